@@ -0,0 +1,509 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// bench.cpp
+// Copyright (c) 2025 ozk
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <omoteura/intro_sort.h>
+#include <omoteura/parallel_intro_sort.h>
+#include <omoteura/parallel_merge_sort.h>
+#include <omoteura/stable_sort.h>
+#include <omoteura/string_sort.h>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace ou = omoteura;
+
+namespace
+{
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // record
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // A 64-byte element ordered by its key, standing in for a row of a table.
+    struct record
+    {
+        std::int64_t key;
+        char payload[56];
+    };
+    static_assert(sizeof(record) == 64, "record should fill one cache line");
+
+    bool operator<(const record &a, const record &b)
+    {
+        return a.key < b.key;
+    }
+
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // options
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    struct options
+    {
+        std::size_t size{1000000};
+        int repetitions{11};
+        std::uint64_t seed{1};
+        std::string format{"text"};
+        std::vector<std::string> types{"int32", "int64", "double", "string", "url", "record64"};
+        std::vector<std::string> inputs{"random", "sorted", "reversed", "few_unique", "organ_pipe", "sawtooth", "k_runs"};
+        std::vector<std::string> algorithms{"ou::intro_sort", "ou::stable_sort", "ou::parallel_intro_sort", "ou::parallel_merge_sort", "ou::string_sort", "std::sort", "std::stable_sort"};
+    };
+
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // result
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    struct result
+    {
+        std::string type;
+        std::string input;
+        std::string algorithm;
+        double median;
+        double p95;
+        double min;
+        bool sorted;
+    };
+
+    std::vector<std::string> split(const std::string &text)
+    {
+        std::vector<std::string> items;
+        std::istringstream stream{text};
+        std::string item;
+        while (std::getline(stream, item, ','))
+        {
+            if (!item.empty())
+            {
+                items.push_back(item);
+            }
+        }
+        return items;
+    }
+
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // make_keys
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Every input starts as non-negative keys below 2^31, so each element type can represent
+    // them exactly and in the same order.
+    std::vector<std::uint64_t> make_keys(const std::string &input, std::size_t n, std::uint64_t seed)
+    {
+        constexpr std::uint64_t keyLimit = std::uint64_t{1} << 31;
+        constexpr std::size_t teeth = 16;
+        constexpr std::size_t runs = 16;
+        constexpr std::uint64_t uniqueKeys = 16;
+        std::mt19937_64 gen{seed};
+        std::uniform_int_distribution<std::uint64_t> dis{0, keyLimit - 1};
+        std::vector<std::uint64_t> keys(n);
+        if (input == "random")
+        {
+            for (std::uint64_t &key : keys)
+            {
+                key = dis(gen);
+            }
+        }
+        else if (input == "sorted")
+        {
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                keys[i] = i;
+            }
+        }
+        else if (input == "reversed")
+        {
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                keys[i] = n - 1 - i;
+            }
+        }
+        else if (input == "few_unique")
+        {
+            for (std::uint64_t &key : keys)
+            {
+                key = dis(gen) % uniqueKeys;
+            }
+        }
+        else if (input == "organ_pipe")
+        {
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                keys[i] = i < n / 2 ? i : n - 1 - i;
+            }
+        }
+        else if (input == "sawtooth")
+        {
+            std::size_t period{std::max<std::size_t>(1, n / teeth)};
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                keys[i] = i % period;
+            }
+        }
+        else if (input == "k_runs")
+        {
+            for (std::uint64_t &key : keys)
+            {
+                key = dis(gen);
+            }
+            for (std::size_t r = 0; r < runs; ++r)
+            {
+                std::sort(keys.begin() + (n * r / runs), keys.begin() + (n * (r + 1) / runs));
+            }
+        }
+        else
+        {
+            throw std::invalid_argument("unknown input: " + input);
+        }
+        return keys;
+    }
+
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // from_key<T>
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename T>
+    T from_key(std::uint64_t key)
+    {
+        if constexpr (std::is_same<T, std::string>::value)
+        {
+            // Fixed width keeps the lexicographic order equal to the numeric one; the length
+            // defeats the small string optimization, as most real keys do.
+            char text[24];
+            std::snprintf(text, sizeof(text), "key-%016llx", static_cast<unsigned long long>(key));
+            return std::string{text};
+        }
+        else if constexpr (std::is_same<T, record>::value)
+        {
+            record item{};
+            item.key = static_cast<std::int64_t>(key);
+            std::memset(item.payload, static_cast<int>(key & 0xff), sizeof(item.payload));
+            return item;
+        }
+        else
+        {
+            return static_cast<T>(key);
+        }
+    }
+
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // url_from_key
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // A string whose first 38 bytes are the same for every key, as in URLs, paths or
+    // namespaced identifiers, so comparisons spend most of their time on the shared prefix.
+    std::string url_from_key(std::uint64_t key)
+    {
+        char text[64];
+        std::snprintf(text, sizeof(text), "https://www.example.com/catalog/items/%016llx",
+                      static_cast<unsigned long long>(key));
+        return std::string{text};
+    }
+
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // supports<T>
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename T>
+    bool supports(const std::string &algorithm)
+    {
+        return algorithm != "ou::string_sort" || std::is_same<T, std::string>::value;
+    }
+
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // sort_with<T>
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename T>
+    void sort_with(const std::string &algorithm, std::vector<T> &items)
+    {
+        if (algorithm == "ou::intro_sort")
+        {
+            ou::intro_sort(items.begin(), items.end());
+        }
+        else if (algorithm == "ou::stable_sort")
+        {
+            ou::stable_sort(items.begin(), items.end());
+        }
+        else if (algorithm == "ou::parallel_intro_sort")
+        {
+            ou::parallel_intro_sort(items.begin(), items.end());
+        }
+        else if (algorithm == "ou::parallel_merge_sort")
+        {
+            ou::parallel_merge_sort(items.begin(), items.end());
+        }
+        else if (algorithm == "ou::heap_sort")
+        {
+            ou::heap_sort(items.begin(), items.end());
+        }
+        else if (algorithm == "ou::string_sort")
+        {
+            if constexpr (std::is_same<T, std::string>::value)
+            {
+                ou::string_sort(items.begin(), items.end());
+            }
+            else
+            {
+                throw std::invalid_argument("ou::string_sort sorts strings only");
+            }
+        }
+        else if (algorithm == "std::sort")
+        {
+            std::sort(items.begin(), items.end());
+        }
+        else if (algorithm == "std::stable_sort")
+        {
+            std::stable_sort(items.begin(), items.end());
+        }
+        else
+        {
+            throw std::invalid_argument("unknown algorithm: " + algorithm);
+        }
+    }
+
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // measure<T>
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Times the algorithm once untimed to warm up caches and the allocator, then
+    // options.repetitions times on fresh copies of the same input.
+    template <typename T>
+    result measure(const std::string &type,
+                   const std::string &input,
+                   const std::string &algorithm,
+                   const std::vector<T> &inputItems,
+                   const options &opts)
+    {
+        result r{type, input, algorithm, 0.0, 0.0, 0.0, true};
+        std::vector<double> seconds;
+        seconds.reserve(static_cast<std::size_t>(opts.repetitions));
+        for (int rep = -1; rep < opts.repetitions; ++rep)
+        {
+            std::vector<T> items{inputItems};
+            std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+            sort_with(algorithm, items);
+            std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+            r.sorted = r.sorted && std::is_sorted(items.begin(), items.end());
+            if (rep >= 0)
+            {
+                seconds.push_back(std::chrono::duration<double>(end - start).count());
+            }
+        }
+        std::sort(seconds.begin(), seconds.end());
+        std::size_t count{seconds.size()};
+        r.min = seconds.front();
+        r.median = count % 2 == 1 ? seconds[count / 2] : (seconds[count / 2 - 1] + seconds[count / 2]) / 2;
+        // Nearest-rank percentile.
+        std::size_t rank{(count * 95 + 99) / 100};
+        r.p95 = seconds[std::max<std::size_t>(rank, 1) - 1];
+        return r;
+    }
+
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // run_type<T>
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename T>
+    void run_type(const std::string &type,
+                  const options &opts,
+                  std::vector<result> &results,
+                  T (*make_item)(std::uint64_t) = from_key<T>)
+    {
+        for (const std::string &input : opts.inputs)
+        {
+            std::vector<std::uint64_t> keys{make_keys(input, opts.size, opts.seed)};
+            std::vector<T> items;
+            items.reserve(keys.size());
+            for (std::uint64_t key : keys)
+            {
+                items.push_back(make_item(key));
+            }
+            for (const std::string &algorithm : opts.algorithms)
+            {
+                if (!supports<T>(algorithm))
+                {
+                    continue;
+                }
+                results.push_back(measure(type, input, algorithm, items, opts));
+                if (opts.format == "text")
+                {
+                    const result &r{results.back()};
+                    std::cout << std::left << std::setw(10) << r.type
+                              << std::setw(12) << r.input
+                              << std::setw(26) << r.algorithm << std::right << std::fixed
+                              << std::setprecision(3) << std::setw(10) << r.median * 1000.0
+                              << std::setw(10) << r.p95 * 1000.0
+                              << std::setprecision(2) << std::setw(12) << opts.size / r.median / 1000000.0
+                              << (r.sorted ? "" : "  NOT SORTED") << std::endl;
+                }
+            }
+        }
+    }
+
+    void print_csv(const std::vector<result> &results, const options &opts)
+    {
+        std::cout << "type,input,algorithm,size,repetitions,median_s,p95_s,min_s,elements_per_s,sorted" << std::endl;
+        std::cout << std::setprecision(9);
+        for (const result &r : results)
+        {
+            std::cout << r.type << ',' << r.input << ',' << r.algorithm << ',' << opts.size << ','
+                      << opts.repetitions << ',' << r.median << ',' << r.p95 << ',' << r.min << ','
+                      << opts.size / r.median << ',' << (r.sorted ? "true" : "false") << std::endl;
+        }
+    }
+
+    void print_json(const std::vector<result> &results, const options &opts)
+    {
+        std::cout << std::setprecision(9);
+        std::cout << "{" << std::endl;
+        std::cout << "  \"version\": \"" << OMOTEURA_INTROSORT_VERSION_MAJOR << '.'
+                  << OMOTEURA_INTROSORT_VERSION_MINOR << '.' << OMOTEURA_INTROSORT_VERSION_PATCH << "\"," << std::endl;
+        std::cout << "  \"size\": " << opts.size << "," << std::endl;
+        std::cout << "  \"repetitions\": " << opts.repetitions << "," << std::endl;
+        std::cout << "  \"seed\": " << opts.seed << "," << std::endl;
+        std::cout << "  \"results\": [" << std::endl;
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            const result &r{results[i]};
+            std::cout << "    {\"type\": \"" << r.type << "\", \"input\": \"" << r.input
+                      << "\", \"algorithm\": \"" << r.algorithm << "\", \"median_s\": " << r.median
+                      << ", \"p95_s\": " << r.p95 << ", \"min_s\": " << r.min
+                      << ", \"elements_per_s\": " << opts.size / r.median
+                      << ", \"sorted\": " << (r.sorted ? "true" : "false") << "}"
+                      << (i + 1 < results.size() ? "," : "") << std::endl;
+        }
+        std::cout << "  ]" << std::endl;
+        std::cout << "}" << std::endl;
+    }
+
+    void print_usage()
+    {
+        std::cerr << "Usage: bench [--size N] [--repetitions N] [--seed N] [--format text|csv|json]" << std::endl
+                  << "             [--types int32,int64,double,string,url,record64]" << std::endl
+                  << "             [--inputs random,sorted,reversed,few_unique,organ_pipe,sawtooth,k_runs]" << std::endl
+                  << "             [--algorithms ou::intro_sort,ou::stable_sort,ou::parallel_intro_sort," << std::endl
+                  << "                           ou::parallel_merge_sort,ou::string_sort,ou::heap_sort,std::sort," << std::endl
+                  << "                           std::stable_sort]" << std::endl;
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        options opts;
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string name{argv[i]};
+            if (i + 1 >= argc)
+            {
+                print_usage();
+                return 1;
+            }
+            std::string value{argv[++i]};
+            if (name == "--size")
+            {
+                opts.size = static_cast<std::size_t>(std::stoull(value));
+            }
+            else if (name == "--repetitions")
+            {
+                opts.repetitions = std::stoi(value);
+            }
+            else if (name == "--seed")
+            {
+                opts.seed = std::stoull(value);
+            }
+            else if (name == "--format")
+            {
+                opts.format = value;
+            }
+            else if (name == "--types")
+            {
+                opts.types = split(value);
+            }
+            else if (name == "--inputs")
+            {
+                opts.inputs = split(value);
+            }
+            else if (name == "--algorithms")
+            {
+                opts.algorithms = split(value);
+            }
+            else
+            {
+                print_usage();
+                return 1;
+            }
+        }
+        if (opts.size == 0 || opts.repetitions <= 0 ||
+            (opts.format != "text" && opts.format != "csv" && opts.format != "json"))
+        {
+            print_usage();
+            return 1;
+        }
+
+        if (opts.format == "text")
+        {
+            std::cout << "OMOTEURA_INTROSORT_VERSION = " << OMOTEURA_INTROSORT_VERSION << std::endl;
+            std::cout << opts.size << " items, " << opts.repetitions << " repetitions, seed " << opts.seed << std::endl;
+            std::cout << std::left << std::setw(10) << "type" << std::setw(12) << "input" << std::setw(26)
+                      << "algorithm" << std::right << std::setw(10) << "median" << std::setw(10) << "p95"
+                      << std::setw(12) << "Melem/s" << std::endl;
+            std::cout << std::setw(58) << "[ms]" << std::setw(10) << "[ms]" << std::endl;
+        }
+
+        std::vector<result> results;
+        for (const std::string &type : opts.types)
+        {
+            if (type == "int32")
+            {
+                run_type<std::int32_t>(type, opts, results);
+            }
+            else if (type == "int64")
+            {
+                run_type<std::int64_t>(type, opts, results);
+            }
+            else if (type == "double")
+            {
+                run_type<double>(type, opts, results);
+            }
+            else if (type == "string")
+            {
+                run_type<std::string>(type, opts, results);
+            }
+            else if (type == "url")
+            {
+                run_type<std::string>(type, opts, results, url_from_key);
+            }
+            else if (type == "record64")
+            {
+                run_type<record>(type, opts, results);
+            }
+            else
+            {
+                throw std::invalid_argument("unknown type: " + type);
+            }
+        }
+
+        if (opts.format == "csv")
+        {
+            print_csv(results, opts);
+        }
+        else if (opts.format == "json")
+        {
+            print_json(results, opts);
+        }
+
+        bool allSorted{std::all_of(results.begin(), results.end(), [](const result &r) { return r.sorted; })};
+        if (!allSorted)
+        {
+            std::cerr << "Some algorithms did not sort their input." << std::endl;
+            return 1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "An exception occurred: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
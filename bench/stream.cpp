@@ -0,0 +1,249 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// stream.cpp
+// Copyright (c) 2025 ozk
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <omoteura/intro_sort.h>
+#include <omoteura/sort_stream.h>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ou = omoteura;
+
+namespace
+{
+    using clock_type = std::chrono::steady_clock;
+
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // options
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    struct options
+    {
+        std::size_t size{4000000};
+        std::size_t batch{4096};
+        double seconds{2.0};
+        unsigned threads{1};
+        std::size_t chunk{0};
+        int repetitions{5};
+        std::uint64_t seed{1};
+    };
+
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // latency
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Seconds from the arrival of the last batch to the first and to the last sorted element.
+    struct latency
+    {
+        double first;
+        double last;
+        bool sorted;
+    };
+
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // producer
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Hands out the input in batches spread evenly over opts.seconds, sleeping until each is
+    // due, like a decoder that waits on its source. Returns when the last batch has arrived.
+    template <typename Sink>
+    clock_type::time_point produce(const std::vector<std::uint64_t> &items, const options &opts, Sink sink)
+    {
+        clock_type::time_point start{clock_type::now()};
+        std::size_t batches{(items.size() + opts.batch - 1) / opts.batch};
+        for (std::size_t b = 0; b < batches; ++b)
+        {
+            std::chrono::duration<double> due{opts.seconds * static_cast<double>(b + 1) / static_cast<double>(batches)};
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<clock_type::duration>(due));
+            std::size_t begin{b * opts.batch};
+            std::size_t end{std::min(items.size(), begin + opts.batch)};
+            sink(items.data() + begin, items.data() + end);
+        }
+        return clock_type::now();
+    }
+
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // consumer
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Checks the order of what it is given and notes when the first element came.
+    struct consumer
+    {
+        void operator()(std::uint64_t item)
+        {
+            if (count == 0)
+            {
+                first = clock_type::now();
+            }
+            else if (item < previous)
+            {
+                sorted = false;
+            }
+            previous = item;
+            ++count;
+        }
+
+        clock_type::time_point first{};
+        std::uint64_t previous{0};
+        std::size_t count{0};
+        bool sorted{true};
+    };
+
+    latency seconds_since(clock_type::time_point arrived, const consumer &c, std::size_t size)
+    {
+        clock_type::time_point last{clock_type::now()};
+        return latency{std::chrono::duration<double>(c.first - arrived).count(),
+                       std::chrono::duration<double>(last - arrived).count(),
+                       c.sorted && c.count == size};
+    }
+
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // collect_then_sort
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    latency collect_then_sort(const std::vector<std::uint64_t> &items, const options &opts)
+    {
+        std::vector<std::uint64_t> collected;
+        collected.reserve(items.size());
+        clock_type::time_point arrived{produce(items, opts, [&collected](const std::uint64_t *first, const std::uint64_t *last) {
+            collected.insert(collected.end(), first, last);
+        })};
+        ou::intro_sort(collected.begin(), collected.end());
+        consumer c;
+        for (std::uint64_t item : collected)
+        {
+            c(item);
+        }
+        return seconds_since(arrived, c, items.size());
+    }
+
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // stream_sort
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    latency stream_sort(const std::vector<std::uint64_t> &items, const options &opts)
+    {
+        ou::sort_stream_options streamOptions;
+        streamOptions.chunk_size = opts.chunk;
+        streamOptions.threads = opts.threads;
+        ou::sort_stream<std::uint64_t> stream{streamOptions};
+        clock_type::time_point arrived{produce(items, opts, [&stream](const std::uint64_t *first, const std::uint64_t *last) {
+            stream.push(first, last);
+        })};
+        consumer c;
+        for (std::uint64_t item : stream)
+        {
+            c(item);
+        }
+        return seconds_since(arrived, c, items.size());
+    }
+
+    double median(std::vector<double> values)
+    {
+        std::sort(values.begin(), values.end());
+        std::size_t count{values.size()};
+        return count % 2 == 1 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2;
+    }
+
+    void print_usage()
+    {
+        std::cerr << "Usage: stream [--size N] [--batch N] [--seconds S] [--threads N] [--chunk N]" << std::endl
+                  << "              [--repetitions N] [--seed N]" << std::endl;
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        options opts;
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string name{argv[i]};
+            if (i + 1 >= argc)
+            {
+                print_usage();
+                return 1;
+            }
+            std::string value{argv[++i]};
+            if (name == "--size")
+            {
+                opts.size = static_cast<std::size_t>(std::stoull(value));
+            }
+            else if (name == "--batch")
+            {
+                opts.batch = static_cast<std::size_t>(std::stoull(value));
+            }
+            else if (name == "--seconds")
+            {
+                opts.seconds = std::stod(value);
+            }
+            else if (name == "--threads")
+            {
+                opts.threads = static_cast<unsigned>(std::stoul(value));
+            }
+            else if (name == "--chunk")
+            {
+                opts.chunk = static_cast<std::size_t>(std::stoull(value));
+            }
+            else if (name == "--repetitions")
+            {
+                opts.repetitions = std::stoi(value);
+            }
+            else if (name == "--seed")
+            {
+                opts.seed = std::stoull(value);
+            }
+            else
+            {
+                print_usage();
+                return 1;
+            }
+        }
+        if (opts.size == 0 || opts.batch == 0 || opts.seconds < 0.0 || opts.repetitions <= 0)
+        {
+            print_usage();
+            return 1;
+        }
+
+        std::mt19937_64 gen{opts.seed};
+        std::vector<std::uint64_t> items(opts.size);
+        for (std::uint64_t &item : items)
+        {
+            item = gen();
+        }
+
+        std::cout << opts.size << " int64 items in batches of " << opts.batch << " over " << opts.seconds
+                  << " s, " << opts.repetitions << " repetitions" << std::endl;
+        std::cout << "latency after the last batch arrives, median" << std::endl;
+        std::cout << std::left << std::setw(22) << "method" << std::right << std::setw(16) << "first item"
+                  << std::setw(16) << "last item" << std::endl;
+        std::cout << std::setw(38) << "[ms]" << std::setw(16) << "[ms]" << std::endl;
+        for (const char *method : {"collect then sort", "ou::sort_stream"})
+        {
+            std::vector<double> firsts;
+            std::vector<double> lasts;
+            bool sorted{true};
+            for (int rep = 0; rep < opts.repetitions; ++rep)
+            {
+                latency l{std::string{method} == "ou::sort_stream" ? stream_sort(items, opts)
+                                                                   : collect_then_sort(items, opts)};
+                firsts.push_back(l.first);
+                lasts.push_back(l.last);
+                sorted = sorted && l.sorted;
+            }
+            std::cout << std::left << std::setw(22) << method << std::right << std::fixed << std::setprecision(3)
+                      << std::setw(16) << median(firsts) * 1000.0 << std::setw(16) << median(lasts) * 1000.0
+                      << (sorted ? "" : "  NOT SORTED") << std::endl;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "An exception occurred: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
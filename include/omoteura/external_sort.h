@@ -0,0 +1,624 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// external_sort.h
+// Copyright (c) 2025 ozk
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "intro_sort.h"
+
+namespace omoteura
+{
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // external_sort_options
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    struct external_sort_options
+    {
+        // Bytes per record; the input must be a whole number of records.
+        std::size_t record_size{0};
+        // Memory for one sorted run, including the (key, index) array, and for the buffers of
+        // one merge.
+        std::size_t memory_budget{std::size_t{256} << 20};
+        // Bytes per read or write while merging; rounded down to whole records.
+        std::size_t block_size{std::size_t{1} << 20};
+        // Runs are spilled to temp_prefix followed by a number, or to std::tmpfile() when empty.
+        // Concurrent sorts need different prefixes.
+        std::string temp_prefix;
+    };
+
+    template <typename KeyExtractor, typename Compare>
+    void external_sort(const std::string &input,
+                       const std::string &output,
+                       const external_sort_options &options,
+                       KeyExtractor key,
+                       Compare comp);
+
+    namespace detail
+    {
+        struct file_closer
+        {
+            void operator()(std::FILE *file) const
+            {
+                std::fclose(file);
+            }
+        };
+
+        using file_handle = std::unique_ptr<std::FILE, file_closer>;
+
+        [[noreturn]] inline void throw_io_error(const std::string &what)
+        {
+            int error{errno != 0 ? errno : EIO};
+            throw std::system_error{error, std::generic_category(), "external_sort: " + what};
+        }
+
+        inline file_handle open_file(const std::string &path, const char *mode)
+        {
+            errno = 0;
+            file_handle file{std::fopen(path.c_str(), mode)};
+            if (!file)
+            {
+                throw_io_error("cannot open " + path);
+            }
+            return file;
+        }
+
+        // Reads until size bytes or the end of the file and returns the number of bytes read.
+        inline std::size_t read_fully(std::FILE *file, unsigned char *data, std::size_t size)
+        {
+            std::size_t done{0};
+            while (done < size)
+            {
+                std::size_t count{std::fread(data + done, 1, size - done, file)};
+                if (count == 0)
+                {
+                    if (std::ferror(file))
+                    {
+                        throw_io_error("read failed");
+                    }
+                    break;
+                }
+                done += count;
+            }
+            return done;
+        }
+
+        inline void write_fully(std::FILE *file, const unsigned char *data, std::size_t size)
+        {
+            if (std::fwrite(data, 1, size, file) != size)
+            {
+                throw_io_error("write failed");
+            }
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // temp_file
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // A spilled run, removed when destroyed.
+        class temp_file
+        {
+        public:
+            explicit temp_file(const std::string &path)
+                : path_(path)
+            {
+                errno = 0;
+                file_.reset(path_.empty() ? std::tmpfile() : std::fopen(path_.c_str(), "w+b"));
+                if (!file_)
+                {
+                    throw_io_error("cannot create " + (path_.empty() ? std::string{"a temporary file"} : path_));
+                }
+            }
+
+            temp_file(const temp_file &) = delete;
+            temp_file &operator=(const temp_file &) = delete;
+
+            ~temp_file()
+            {
+                file_.reset();
+                if (!path_.empty())
+                {
+                    std::remove(path_.c_str());
+                }
+            }
+
+            std::FILE *get() const
+            {
+                return file_.get();
+            }
+
+        private:
+            std::string path_;
+            file_handle file_;
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // io_queue
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Runs reads and writes in order on one background thread, so the merge never waits for
+        // a block that could have been fetched while it was busy.
+        class io_queue
+        {
+        public:
+            io_queue()
+                : worker_([this] { work(); })
+            {
+            }
+
+            io_queue(const io_queue &) = delete;
+            io_queue &operator=(const io_queue &) = delete;
+
+            // Finishes the queued jobs first.
+            ~io_queue()
+            {
+                {
+                    std::lock_guard<std::mutex> lock{mutex_};
+                    stopping_ = true;
+                }
+                ready_.notify_one();
+                worker_.join();
+            }
+
+            std::future<void> submit(std::function<void()> job)
+            {
+                std::packaged_task<void()> task{std::move(job)};
+                std::future<void> done{task.get_future()};
+                {
+                    std::lock_guard<std::mutex> lock{mutex_};
+                    jobs_.push_back(std::move(task));
+                }
+                ready_.notify_one();
+                return done;
+            }
+
+        private:
+            void work()
+            {
+                while (true)
+                {
+                    std::packaged_task<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock{mutex_};
+                        ready_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+                        if (jobs_.empty())
+                        {
+                            return;
+                        }
+                        task = std::move(jobs_.front());
+                        jobs_.pop_front();
+                    }
+                    task();
+                }
+            }
+
+            std::mutex mutex_;
+            std::condition_variable ready_;
+            std::deque<std::packaged_task<void()>> jobs_;
+            bool stopping_{false};
+            std::thread worker_;
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // block_reader
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Hands out the records of a file one at a time while the next block is read in the
+        // background.
+        class block_reader
+        {
+        public:
+            block_reader(std::FILE *file, std::size_t blockSize, std::size_t recordSize, io_queue &io)
+                : file_(file), recordSize_(recordSize), io_(io), current_(blockSize), next_(blockSize)
+            {
+                fetch();
+                advance();
+            }
+
+            block_reader(const block_reader &) = delete;
+            block_reader &operator=(const block_reader &) = delete;
+
+            ~block_reader()
+            {
+                if (pending_.valid())
+                {
+                    pending_.wait();
+                }
+            }
+
+            // Returns the next record, or nullptr after the last one. The record stays valid
+            // until the next call.
+            const unsigned char *next()
+            {
+                if (position_ == size_)
+                {
+                    if (size_ == 0)
+                    {
+                        return nullptr;
+                    }
+                    advance();
+                    if (size_ == 0)
+                    {
+                        return nullptr;
+                    }
+                }
+                const unsigned char *record{current_.data() + position_};
+                position_ += recordSize_;
+                return record;
+            }
+
+        private:
+            void fetch()
+            {
+                pending_ = io_.submit([this] { nextSize_ = read_fully(file_, next_.data(), next_.size()); });
+            }
+
+            void advance()
+            {
+                pending_.get();
+                current_.swap(next_);
+                size_ = nextSize_;
+                position_ = 0;
+                if (size_ % recordSize_ != 0)
+                {
+                    throw std::runtime_error{"external_sort: input size is not a multiple of the record size"};
+                }
+                if (size_ > 0)
+                {
+                    fetch();
+                }
+            }
+
+            std::FILE *file_;
+            std::size_t recordSize_;
+            io_queue &io_;
+            std::vector<unsigned char> current_;
+            std::vector<unsigned char> next_;
+            std::size_t size_{0};
+            std::size_t nextSize_{0};
+            std::size_t position_{0};
+            std::future<void> pending_;
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // block_writer
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Collects records into blocks and writes each full block in the background while the
+        // next one fills.
+        class block_writer
+        {
+        public:
+            block_writer(std::FILE *file, std::size_t blockSize, io_queue &io)
+                : file_(file), io_(io), current_(blockSize), next_(blockSize)
+            {
+            }
+
+            block_writer(const block_writer &) = delete;
+            block_writer &operator=(const block_writer &) = delete;
+
+            ~block_writer()
+            {
+                if (pending_.valid())
+                {
+                    pending_.wait();
+                }
+            }
+
+            void write(const unsigned char *record, std::size_t size)
+            {
+                if (filled_ + size > current_.size())
+                {
+                    flush();
+                }
+                std::memcpy(current_.data() + filled_, record, size);
+                filled_ += size;
+            }
+
+            // Writes what is left and waits for it; reports any error of an earlier write.
+            void finish()
+            {
+                flush();
+                if (pending_.valid())
+                {
+                    pending_.get();
+                }
+                if (std::fflush(file_) != 0)
+                {
+                    throw_io_error("write failed");
+                }
+            }
+
+        private:
+            void flush()
+            {
+                if (filled_ == 0)
+                {
+                    return;
+                }
+                if (pending_.valid())
+                {
+                    pending_.get();
+                }
+                current_.swap(next_);
+                std::size_t size{filled_};
+                filled_ = 0;
+                pending_ = io_.submit([this, size] { write_fully(file_, next_.data(), size); });
+            }
+
+            std::FILE *file_;
+            io_queue &io_;
+            std::vector<unsigned char> current_;
+            std::vector<unsigned char> next_;
+            std::size_t filled_{0};
+            std::future<void> pending_;
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // make_runs<Key, KeyExtractor, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Reads the input one memory budget at a time, sorts each part by key and spills it as a
+        // run. When the whole input fits in one part, it goes straight to output and no runs are
+        // returned.
+        template <typename Key, typename KeyExtractor, typename Compare>
+        std::vector<std::unique_ptr<temp_file>> make_runs(const std::string &input,
+                                                          const std::string &output,
+                                                          const external_sort_options &options,
+                                                          std::size_t blockSize,
+                                                          KeyExtractor &key,
+                                                          Compare &comp,
+                                                          io_queue &io)
+        {
+            using Entry = std::pair<Key, std::size_t>;
+            std::size_t recordSize{options.record_size};
+            // Radix sort needs a second array of entries.
+            std::size_t capacity{std::max<std::size_t>(1, options.memory_budget / (recordSize + 2 * sizeof(Entry)))};
+            std::vector<unsigned char> records(capacity * recordSize);
+            std::vector<Entry> entries;
+            entries.reserve(capacity);
+
+            file_handle in{open_file(input, "rb")};
+            std::vector<std::unique_ptr<temp_file>> runs;
+            while (true)
+            {
+                std::size_t size{read_fully(in.get(), records.data(), records.size())};
+                if (size % recordSize != 0)
+                {
+                    throw std::runtime_error{"external_sort: input size is not a multiple of the record size"};
+                }
+                bool last{size < records.size()};
+                if (!last)
+                {
+                    int c{std::fgetc(in.get())};
+                    last = c == EOF;
+                    if (!last)
+                    {
+                        std::ungetc(c, in.get());
+                    }
+                }
+                std::size_t count{size / recordSize};
+                entries.clear();
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    entries.emplace_back(std::invoke(key, records.data() + i * recordSize), i);
+                }
+                sort_key_entries(entries.begin(), entries.end(), comp);
+
+                file_handle direct;
+                std::FILE *file;
+                if (last && runs.empty())
+                {
+                    direct = open_file(output, "wb");
+                    file = direct.get();
+                }
+                else
+                {
+                    runs.push_back(std::make_unique<temp_file>(
+                        options.temp_prefix.empty() ? std::string{} : options.temp_prefix + std::to_string(runs.size())));
+                    file = runs.back()->get();
+                }
+                block_writer writer{file, blockSize, io};
+                for (const Entry &entry : entries)
+                {
+                    writer.write(records.data() + entry.second * recordSize, recordSize);
+                }
+                writer.finish();
+                if (direct && std::fclose(direct.release()) != 0)
+                {
+                    throw_io_error("cannot close " + output);
+                }
+                if (last)
+                {
+                    break;
+                }
+            }
+            return runs;
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // merge_runs<Key, KeyExtractor, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Merges runs into file with a loser tree whose players carry the key of their current
+        // record, so each record's key is extracted once per merge.
+        template <typename Key, typename KeyExtractor, typename Compare>
+        void merge_runs(const std::vector<std::unique_ptr<temp_file>> &runs,
+                        std::FILE *file,
+                        std::size_t recordSize,
+                        std::size_t blockSize,
+                        KeyExtractor &key,
+                        Compare &comp,
+                        io_queue &io)
+        {
+            struct player
+            {
+                const unsigned char *record;
+                Key key;
+                int leaf;
+            };
+
+            std::vector<std::unique_ptr<block_reader>> readers;
+            std::vector<player> players;
+            for (const std::unique_ptr<temp_file> &run : runs)
+            {
+                std::rewind(run->get());
+                readers.push_back(std::make_unique<block_reader>(run->get(), blockSize, recordSize, io));
+                if (const unsigned char *record{readers.back()->next()})
+                {
+                    players.push_back(player{record, std::invoke(key, record), 0});
+                }
+                else
+                {
+                    readers.pop_back();
+                }
+            }
+
+            block_writer writer{file, blockSize, io};
+            // Node i of the tree is tree[i - 1].
+            std::vector<player> tree;
+            std::vector<int> winners;
+            // When the winning run runs out, the tree is rebuilt without it.
+            while (players.size() > 1)
+            {
+                int k{static_cast<int>(players.size())};
+                // Leaves are the nodes k to 2k - 1; node 0 is unused.
+                winners.assign(2 * k, 0);
+                std::vector<int> losers(k);
+                for (int i = 0; i < k; ++i)
+                {
+                    players[i].leaf = i;
+                    winners[k + i] = i;
+                }
+                for (int node = k - 1; node > 0; --node)
+                {
+                    int a{winners[2 * node]};
+                    int b{winners[2 * node + 1]};
+                    bool swapped{comp(players[b].key, players[a].key)};
+                    winners[node] = swapped ? b : a;
+                    losers[node] = swapped ? a : b;
+                }
+                tree.clear();
+                for (int node = 1; node < k; ++node)
+                {
+                    tree.push_back(std::move(players[losers[node]]));
+                }
+                player winner{std::move(players[winners[1]])};
+
+                while (true)
+                {
+                    writer.write(winner.record, recordSize);
+                    winner.record = readers[winner.leaf]->next();
+                    if (winner.record == nullptr)
+                    {
+                        break;
+                    }
+                    winner.key = std::invoke(key, winner.record);
+                    for (int node = (winner.leaf + k) / 2; node > 0; node /= 2)
+                    {
+                        if (comp(tree[node - 1].key, winner.key))
+                        {
+                            std::swap(tree[node - 1], winner);
+                        }
+                    }
+                }
+
+                int exhausted{winner.leaf};
+                for (player &loser : tree)
+                {
+                    int leaf{loser.leaf};
+                    players[leaf] = std::move(loser);
+                }
+                players.erase(players.begin() + exhausted);
+                readers.erase(readers.begin() + exhausted);
+            }
+            if (!players.empty())
+            {
+                for (const unsigned char *record{players[0].record}; record != nullptr; record = readers[0]->next())
+                {
+                    writer.write(record, recordSize);
+                }
+            }
+            writer.finish();
+        }
+    } // namespace detail
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // external_sort<KeyExtractor>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename KeyExtractor>
+    void external_sort(const std::string &input,
+                       const std::string &output,
+                       const external_sort_options &options,
+                       KeyExtractor key)
+    {
+        using Key = std::decay_t<std::invoke_result_t<KeyExtractor &, const unsigned char *>>;
+        external_sort(input, output, options, key, std::less<Key>{});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // external_sort<KeyExtractor, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Sorts a file of fixed-size records that may be much larger than memory into output, which
+    // must be a different file. The sort is not stable. key is called with a pointer to a record and returns its key;
+    // comp compares keys. Parts of the input that fit in options.memory_budget are sorted with
+    // intro_sort and spilled as runs, which are then merged with reads and writes of
+    // options.block_size bytes done in the background. When there are more runs than the
+    // budget can hold blocks for, groups of runs are merged into longer runs first.
+    template <typename KeyExtractor, typename Compare>
+    void external_sort(const std::string &input,
+                       const std::string &output,
+                       const external_sort_options &options,
+                       KeyExtractor key,
+                       Compare comp)
+    {
+        using Key = std::decay_t<std::invoke_result_t<KeyExtractor &, const unsigned char *>>;
+        if (options.record_size == 0)
+        {
+            throw std::invalid_argument{"external_sort: record_size must not be 0"};
+        }
+        std::size_t recordSize{options.record_size};
+        std::size_t blockSize{std::max<std::size_t>(1, options.block_size / recordSize) * recordSize};
+        // Each run being merged and the output have two blocks each.
+        std::size_t fanIn{std::max<std::size_t>(3, options.memory_budget / (2 * blockSize)) - 1};
+
+        detail::io_queue io;
+        std::vector<std::unique_ptr<detail::temp_file>> runs{
+            detail::make_runs<Key>(input, output, options, blockSize, key, comp, io)};
+        if (runs.empty())
+        {
+            return;
+        }
+        std::size_t nextName{runs.size()};
+        while (runs.size() > fanIn)
+        {
+            std::vector<std::unique_ptr<detail::temp_file>> group;
+            for (std::size_t i = 0; i < fanIn; ++i)
+            {
+                group.push_back(std::move(runs[i]));
+            }
+            runs.erase(runs.begin(), runs.begin() + static_cast<std::ptrdiff_t>(fanIn));
+            runs.push_back(std::make_unique<detail::temp_file>(
+                options.temp_prefix.empty() ? std::string{} : options.temp_prefix + std::to_string(nextName++)));
+            detail::merge_runs<Key>(group, runs.back()->get(), recordSize, blockSize, key, comp, io);
+        }
+        detail::file_handle out{detail::open_file(output, "wb")};
+        detail::merge_runs<Key>(runs, out.get(), recordSize, blockSize, key, comp, io);
+        if (std::fclose(out.release()) != 0)
+        {
+            detail::throw_io_error("cannot close " + output);
+        }
+    }
+} // namespace omoteura
@@ -8,9 +8,23 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
+#include <vector>
+
+#include "simd_partition.h"
+#include "sort_stats.h"
+#include "sort_workspace.h"
+#include "sorting_network.h"
+#include "static_sort.h"
 
 #define OMOTEURA_INTROSORT_VERSION_MAJOR 1
 #define OMOTEURA_INTROSORT_VERSION_MINOR 0
@@ -25,6 +39,60 @@
 
 namespace omoteura
 {
+    template <typename RandomAccessIterator, typename Compare>
+    void insertion_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp);
+    template <typename RandomAccessIterator, typename Compare>
+    void heap_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp);
+    template <typename HeapPolicy, typename RandomAccessIterator, typename Compare>
+    void heap_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp);
+    template <typename RandomAccessIterator, typename Compare>
+    void quick_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp);
+    template <int Threshold, typename RandomAccessIterator, typename Compare>
+    void quick_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp);
+    template <typename RandomAccessIterator, typename Compare>
+    void intro_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp);
+    template <int Threshold, typename RandomAccessIterator, typename Compare>
+    void intro_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp);
+    template <typename RandomAccessIterator, typename Projection, typename Compare>
+    void intro_sort_by_key(RandomAccessIterator first, RandomAccessIterator last, Projection proj, Compare comp);
+    template <typename RandomAccessIterator, typename Compare>
+    void radix_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp);
+    template <typename RandomAccessIterator, typename Compare>
+    void radix_sort_in_place(RandomAccessIterator first, RandomAccessIterator last, Compare comp);
+    template <typename RandomAccessIterator, typename Compare>
+    void intro_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp, sort_workspace &workspace);
+    template <int Threshold, typename RandomAccessIterator, typename Compare>
+    void intro_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp, sort_workspace &workspace);
+    template <typename RandomAccessIterator, typename Projection, typename Compare>
+    void intro_sort_by_key(RandomAccessIterator first,
+                           RandomAccessIterator last,
+                           Projection proj,
+                           Compare comp,
+                           sort_workspace &workspace);
+    template <typename RandomAccessIterator, typename Compare>
+    void radix_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp, sort_workspace &workspace);
+    template <typename RandomAccessIterator, typename Compare, typename Statistics>
+    void insertion_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp, Statistics &stats);
+    template <typename RandomAccessIterator, typename Compare, typename Statistics>
+    void heap_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp, Statistics &stats);
+    template <typename HeapPolicy, typename RandomAccessIterator, typename Compare, typename Statistics>
+    void heap_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp, Statistics &stats);
+    template <typename RandomAccessIterator, typename Compare, typename Statistics>
+    void quick_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp, Statistics &stats);
+    template <typename RandomAccessIterator, typename Compare, typename Statistics>
+    void intro_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp, Statistics &stats);
+    template <typename RandomAccessIterator, typename Compare>
+    void adaptive_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp);
+
+    namespace detail
+    {
+        template <typename RandomAccessIterator, typename Compare>
+        void down_heap(RandomAccessIterator first,
+                       typename std::iterator_traits<RandomAccessIterator>::difference_type n,
+                       typename std::iterator_traits<RandomAccessIterator>::difference_type i,
+                       Compare comp);
+    } // namespace detail
+
     //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
     // insertion_sort<RandomAccessIterator>
     //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
@@ -71,13 +139,67 @@ namespace omoteura
                         *current = std::move(value);
                         throw;
                     }
+                    detail::count_moves(comp, (i - current) + 2);
                 }
             }
         }
     }
 
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // insertion_sort<RandomAccessIterator, Compare, Statistics>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Statistics is sort_stats to collect statistics into stats, or no_stats to collect nothing.
+    template <typename RandomAccessIterator, typename Compare, typename Statistics>
+    void insertion_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp, Statistics &stats)
+    {
+        static_assert(detail::is_stats_policy<Statistics>::value, "Statistics must be sort_stats or no_stats");
+        if constexpr (std::is_same<Statistics, sort_stats>::value)
+        {
+            insertion_sort(first, last, detail::counting_compare<Compare>{comp, stats});
+        }
+        else
+        {
+            insertion_sort(first, last, comp);
+        }
+    }
+
     namespace detail
     {
+        // Ranges of at most this many elements are left to small_sort by default: a whole
+        // network where small_sort can use one, 16 for insertion_sort otherwise.
+        template <typename RandomAccessIterator, typename Compare>
+        constexpr int leaf_threshold =
+            network_sort_compiled &&
+                    is_network_sortable<typename std::iterator_traits<RandomAccessIterator>::value_type,
+                                        Compare>::value
+                ? network_max_size
+                : 16;
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // small_sort<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Leaves of quick_sort and intro_sort: a SIMD sorting network where the CPU, the value
+        // type and the comparator allow it, insertion_sort otherwise. Integers the SIMD network
+        // does not take go through static_sort first, whose exchanges are conditional moves.
+        template <typename RandomAccessIterator, typename Compare>
+        void small_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+        {
+            using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            if constexpr (std::is_integral<T>::value && !is_counting_compare<Compare>::value)
+            {
+                if (last - first <= fixed_network_max_size &&
+                    !(network_sort_compiled && is_network_sortable<T, Compare>::value))
+                {
+                    fixed_network_sort(first, static_cast<int>(last - first), comp);
+                    return;
+                }
+            }
+            if (!network_sort(first, last, comp))
+            {
+                insertion_sort(first, last, comp);
+            }
+        }
+
         //---------+---------+---------+---------+---------+---------+---------+---------+---------+
         // make_heap<RandomAccessIterator, Compare>
         //---------+---------+---------+---------+---------+---------+---------+---------+---------+
@@ -119,6 +241,156 @@ namespace omoteura
                     if (comp(value, first[child]))
                     {
                         first[i] = std::move(first[child]);
+                        count_moves(comp, 1);
+                        i = child;
+                    }
+                    else
+                    {
+                        break;
+                    }
+                }
+                first[i] = std::move(value);
+                count_moves(comp, 2);
+            }
+            catch (...)
+            {
+                first[i] = std::move(value);
+                throw;
+            }
+        }
+    } // namespace detail
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // binary_heap, bottom_up_heap, dary_heap<Arity>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Heap policies for heap_sort. binary_heap sifts top-down with two comparisons per level.
+    // bottom_up_heap moves the hole down to a leaf with one comparison per level and lets the
+    // displaced element climb back up, which is short because it came from the bottom.
+    // dary_heap sifts the same way with Arity children per node; for contiguous ranges the
+    // children of a node share one cache line.
+    struct binary_heap
+    {
+        static constexpr int arity = 2;
+        static constexpr bool bottom_up = false;
+    };
+
+    struct bottom_up_heap
+    {
+        static constexpr int arity = 2;
+        static constexpr bool bottom_up = true;
+    };
+
+    template <int Arity>
+    struct dary_heap
+    {
+        static_assert(Arity >= 2, "a heap node needs at least two children");
+        static constexpr int arity = Arity;
+        static constexpr bool bottom_up = true;
+    };
+
+    namespace detail
+    {
+        constexpr std::size_t cache_line_size = 64;
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // heap_shape<Arity, Diff>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Node i > 0 has the children [Arity * i + 1 - skew, Arity * i + Arity + 1 - skew) and the
+        // root the children [1, Arity + 1 - skew). A skew of 0 is the usual implicit layout; other
+        // values shift every sibling group by the same amount.
+        template <int Arity, typename Diff>
+        struct heap_shape
+        {
+            Diff skew;
+
+            Diff first_child(Diff i) const
+            {
+                return i == 0 ? 1 : Arity * i + 1 - skew;
+            }
+
+            Diff last_child(Diff i) const
+            {
+                return Arity * i + Arity + 1 - skew;
+            }
+
+            Diff parent(Diff j) const
+            {
+                return (j + skew - 1) / Arity;
+            }
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // make_heap_shape<Arity, RandomAccessIterator>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Picks the skew that starts every sibling group on a multiple of its own size in memory,
+        // so a group never straddles two cache lines.
+        template <int Arity, typename RandomAccessIterator>
+        heap_shape<Arity, typename std::iterator_traits<RandomAccessIterator>::difference_type>
+        make_heap_shape(RandomAccessIterator first)
+        {
+            using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+            heap_shape<Arity, Diff> shape{0};
+            if constexpr (is_contiguous_iterator<RandomAccessIterator>::value &&
+                          cache_line_size % (Arity * sizeof(T)) == 0)
+            {
+                std::uintptr_t address{reinterpret_cast<std::uintptr_t>(std::addressof(*first))};
+                if (address % sizeof(T) == 0)
+                {
+                    shape.skew = static_cast<Diff>((address / sizeof(T) + 1) % Arity);
+                }
+            }
+            return shape;
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // max_child<Arity, RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Returns the child of i that no other child of i is ordered after. i must have a child.
+        template <int Arity, typename RandomAccessIterator, typename Compare>
+        typename std::iterator_traits<RandomAccessIterator>::difference_type
+        max_child(RandomAccessIterator first,
+                  typename std::iterator_traits<RandomAccessIterator>::difference_type n,
+                  typename std::iterator_traits<RandomAccessIterator>::difference_type i,
+                  const heap_shape<Arity, typename std::iterator_traits<RandomAccessIterator>::difference_type> &shape,
+                  Compare comp)
+        {
+            using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+            Diff child{shape.first_child(i)};
+            Diff end{std::min(shape.last_child(i), n)};
+            for (Diff k{child + 1}; k < end; ++k)
+            {
+                if (comp(first[child], first[k]))
+                {
+                    child = k;
+                }
+            }
+            return child;
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // down_heap<Arity, RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <int Arity, typename RandomAccessIterator, typename Compare>
+        void down_heap(RandomAccessIterator first,
+                       typename std::iterator_traits<RandomAccessIterator>::difference_type n,
+                       typename std::iterator_traits<RandomAccessIterator>::difference_type i,
+                       const heap_shape<Arity, typename std::iterator_traits<RandomAccessIterator>::difference_type> &shape,
+                       Compare comp)
+        {
+            using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+            assert(0 <= i && i < n);
+            T value{std::move(first[i])};
+            try
+            {
+                while (shape.first_child(i) < n)
+                {
+                    Diff child{max_child(first, n, i, shape, comp)};
+                    if (comp(value, first[child]))
+                    {
+                        first[i] = std::move(first[child]);
+                        count_moves(comp, 1);
                         i = child;
                     }
                     else
@@ -127,6 +399,7 @@ namespace omoteura
                     }
                 }
                 first[i] = std::move(value);
+                count_moves(comp, 2);
             }
             catch (...)
             {
@@ -134,6 +407,61 @@ namespace omoteura
                 throw;
             }
         }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // pop_heap_bottom_up<Arity, RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Moves the top of the heap [first, first + n) to first + (n - 1) and restores the heap on
+        // the rest. The element from the end only ever climbs, so the comparisons against it stop
+        // near the leaves.
+        template <int Arity, typename RandomAccessIterator, typename Compare>
+        void pop_heap_bottom_up(RandomAccessIterator first,
+                                typename std::iterator_traits<RandomAccessIterator>::difference_type n,
+                                const heap_shape<Arity, typename std::iterator_traits<RandomAccessIterator>::difference_type> &shape,
+                                Compare comp)
+        {
+            using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+            assert(n >= 2);
+            Diff size{n - 1};
+            T value{std::move(first[size])};
+            first[size] = std::move(first[0]);
+            Diff hole{0};
+            try
+            {
+                while (shape.first_child(hole) < size)
+                {
+                    Diff child{max_child(first, size, hole, shape, comp)};
+                    first[hole] = std::move(first[child]);
+                    count_moves(comp, 1);
+                    hole = child;
+                }
+                while (hole > 0)
+                {
+                    Diff parent{shape.parent(hole)};
+                    if (comp(first[parent], value))
+                    {
+                        first[hole] = std::move(first[parent]);
+                        count_moves(comp, 1);
+                        hole = parent;
+                    }
+                    else
+                    {
+                        break;
+                    }
+                }
+                first[hole] = std::move(value);
+                count_moves(comp, 3);
+            }
+            catch (...)
+            {
+                first[hole] = std::move(value);
+                throw;
+            }
+        }
+
+        // The policy intro_sort falls back to once its depth limit is spent.
+        using fallback_heap = dary_heap<4>;
     } // namespace detail
 
     //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
@@ -151,66 +479,161 @@ namespace omoteura
     //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
     template <typename RandomAccessIterator, typename Compare>
     void heap_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+    {
+        heap_sort<binary_heap>(first, last, comp);
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // heap_sort<HeapPolicy, RandomAccessIterator>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename HeapPolicy, typename RandomAccessIterator>
+    void heap_sort(RandomAccessIterator first, RandomAccessIterator last)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        heap_sort<HeapPolicy>(first, last, std::less<T>{});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // heap_sort<HeapPolicy, RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // HeapPolicy is binary_heap, bottom_up_heap or dary_heap<Arity>.
+    template <typename HeapPolicy, typename RandomAccessIterator, typename Compare>
+    void heap_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
     {
         using std::swap;
         using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
         Diff n{last - first};
-        if (n >= 2)
+        if (n < 2)
+        {
+            return;
+        }
+        if constexpr (HeapPolicy::bottom_up)
+        {
+            auto shape{detail::make_heap_shape<HeapPolicy::arity>(first)};
+            for (Diff i{shape.parent(n - 1) + 1}; i > 0; --i)
+            {
+                detail::down_heap(first, n, i - 1, shape, comp);
+            }
+            for (; n > 1; --n)
+            {
+                detail::pop_heap_bottom_up(first, n, shape, comp);
+            }
+        }
+        else
         {
+            static_assert(HeapPolicy::arity == 2, "top-down sifting is implemented for binary heaps only");
             detail::make_heap(first, n, comp);
             do
             {
                 --n;
                 swap(first[0], first[n]);
+                detail::count_swaps(comp, 1);
                 detail::down_heap(first, n, 0, comp);
             } while (n > 1);
         }
     }
 
     //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
-    // quick_sort<RandomAccessIterator>
+    // heap_sort<RandomAccessIterator, Compare, Statistics>
     //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
-    template <typename RandomAccessIterator>
-    void quick_sort(RandomAccessIterator first, RandomAccessIterator last)
+    template <typename RandomAccessIterator, typename Compare, typename Statistics>
+    void heap_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp, Statistics &stats)
     {
-        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
-        quick_sort(first, last, std::less<T>{});
+        heap_sort<binary_heap>(first, last, comp, stats);
     }
 
     //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
-    // quick_sort<RandomAccessIterator, Compare>
+    // heap_sort<HeapPolicy, RandomAccessIterator, Compare, Statistics>
     //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
-    template <typename RandomAccessIterator, typename Compare>
-    void quick_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+    template <typename HeapPolicy, typename RandomAccessIterator, typename Compare, typename Statistics>
+    void heap_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp, Statistics &stats)
     {
-        using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
-        using std::swap;
-        constexpr int threshold = 16;
-        Diff n{last - first};
-        if (n <= threshold)
+        static_assert(detail::is_stats_policy<Statistics>::value, "Statistics must be sort_stats or no_stats");
+        if constexpr (std::is_same<Statistics, sort_stats>::value)
         {
-            insertion_sort(first, last, comp);
+            heap_sort<HeapPolicy>(first, last, detail::counting_compare<Compare>{comp, stats});
         }
         else
         {
+            heap_sort<HeapPolicy>(first, last, comp);
+        }
+    }
+
+    namespace detail
+    {
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // is_branchless_compare<T, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Comparators whose result can be turned into an integer without a branch.
+        template <typename T, typename Compare>
+        struct is_branchless_compare : std::false_type
+        {
+        };
+
+        template <typename T>
+        struct is_branchless_compare<T, std::less<T>> : std::is_arithmetic<T>
+        {
+        };
+
+        template <typename T>
+        struct is_branchless_compare<T, std::greater<T>> : std::is_arithmetic<T>
+        {
+        };
+
+        template <typename T>
+        struct is_branchless_compare<T, std::less<>> : std::is_arithmetic<T>
+        {
+        };
+
+        template <typename T>
+        struct is_branchless_compare<T, std::greater<>> : std::is_arithmetic<T>
+        {
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // move_pivot_to_last<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Median of the first, middle and last elements. Returns true when the median is equal to
+        // one of the other two, which hints at many duplicate keys.
+        template <typename RandomAccessIterator, typename Compare>
+        bool move_pivot_to_last(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+        {
+            using std::swap;
+            assert(last - first >= 3);
             RandomAccessIterator l{first};
             RandomAccessIterator r{last - 1};
-            RandomAccessIterator m{first + (n / 2)};
+            RandomAccessIterator m{first + ((last - first) / 2)};
             if (comp(*m, *l))
             {
                 swap(*l, *m);
+                count_swaps(comp, 1);
             }
             if (comp(*r, *l))
             {
                 swap(*l, *r);
+                count_swaps(comp, 1);
             }
             if (comp(*m, *r))
             {
                 swap(*m, *r);
+                count_swaps(comp, 1);
             }
-            // r is pivot
-            RandomAccessIterator i{l};
-            RandomAccessIterator j{r - 1};
+            return !comp(*l, *r) || !comp(*r, *m);
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // partition_hoare<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Partitions [i, j] around the pivot *r and moves the pivot to its final position.
+        // second is true when no element had to be swapped.
+        template <typename RandomAccessIterator, typename Compare>
+        std::pair<RandomAccessIterator, bool> partition_hoare(RandomAccessIterator i,
+                                                              RandomAccessIterator j,
+                                                              RandomAccessIterator r,
+                                                              Compare comp)
+        {
+            using std::swap;
+            bool alreadyPartitioned{true};
             while (true)
             {
                 while (i <= j && comp(*i, *r))
@@ -226,85 +649,1247 @@ namespace omoteura
                     break;
                 }
                 swap(*i, *j);
+                count_swaps(comp, 1);
+                alreadyPartitioned = false;
                 ++i;
                 --j;
             }
             swap(*i, *r);
-            quick_sort(first, i, comp);
-            quick_sort(i + 1, last, comp);
+            count_swaps(comp, 1);
+            return {i, alreadyPartitioned};
         }
-    }
 
-    namespace detail
-    {
         //---------+---------+---------+---------+---------+---------+---------+---------+---------+
-        // intro_sort_impl<RandomAccessIterator, Compare>
+        // partition_block<RandomAccessIterator, Compare>
         //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // BlockQuicksort: offsets of misplaced elements are collected without branching and then
+        // swapped in a batch. Equal elements are treated as misplaced on both sides, like the
+        // Hoare loop, so runs of equal keys still split evenly.
         template <typename RandomAccessIterator, typename Compare>
-        void intro_sort_impl(RandomAccessIterator first,
-                             RandomAccessIterator last,
-                             Compare comp,
-                             int depthLimit)
+        std::pair<RandomAccessIterator, bool> partition_block(RandomAccessIterator first,
+                                                              RandomAccessIterator last,
+                                                              Compare comp)
         {
-            using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+            using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
             using std::swap;
-            constexpr int threshold = 16;
-            Diff n{last - first};
-            if (n <= threshold)
-            {
-                insertion_sort(first, last, comp);
-            }
-            else
+            constexpr int blockSize = 64;
+            RandomAccessIterator r{last - 1};
+            const T pivot{*r};
+            unsigned char offsetsL[blockSize];
+            unsigned char offsetsR[blockSize];
+            int numL{0};
+            int numR{0};
+            int startL{0};
+            int startR{0};
+            bool alreadyPartitioned{true};
+            RandomAccessIterator l{first};
+            RandomAccessIterator u{r};
+            while (u - l > 2 * blockSize)
             {
-                if (depthLimit <= 0)
-                {
-                    heap_sort(first, last, comp);
-                }
-                else
+                if (numL == 0)
                 {
-                    RandomAccessIterator l{first};
-                    RandomAccessIterator r{last - 1};
-                    RandomAccessIterator m{first + (n / 2)};
-                    if (comp(*m, *l))
-                    {
-                        swap(*l, *m);
-                    }
-                    if (comp(*r, *l))
-                    {
-                        swap(*l, *r);
-                    }
-                    if (comp(*m, *r))
+                    startL = 0;
+                    for (int k = 0; k < blockSize; ++k)
                     {
-                        swap(*m, *r);
+                        offsetsL[numL] = static_cast<unsigned char>(k);
+                        numL += !comp(l[k], pivot);
                     }
-                    // r is pivot
-                    RandomAccessIterator i{l};
-                    RandomAccessIterator j{r - 1};
-                    while (true)
+                }
+                if (numR == 0)
+                {
+                    startR = 0;
+                    for (int k = 0; k < blockSize; ++k)
                     {
-                        while (i <= j && comp(*i, *r))
-                        {
-                            ++i;
-                        }
-                        while (j >= i && comp(*r, *j))
-                        {
-                            --j;
-                        }
-                        if (i >= j)
-                        {
-                            break;
-                        }
-                        swap(*i, *j);
-                        ++i;
-                        --j;
+                        offsetsR[numR] = static_cast<unsigned char>(k);
+                        numR += !comp(pivot, *(u - 1 - k));
                     }
-                    swap(*i, *r);
-                    intro_sort_impl(first, i, comp, depthLimit - 1);
-                    intro_sort_impl(i + 1, last, comp, depthLimit - 1);
+                }
+                int num{std::min(numL, numR)};
+                alreadyPartitioned = alreadyPartitioned && num == 0;
+                for (int k = 0; k < num; ++k)
+                {
+                    swap(l[offsetsL[startL + k]], *(u - 1 - offsetsR[startR + k]));
+                }
+                numL -= num;
+                numR -= num;
+                startL += num;
+                startR += num;
+                if (numL == 0)
+                {
+                    l += blockSize;
+                }
+                if (numR == 0)
+                {
+                    u -= blockSize;
                 }
             }
+            // Everything left of l is <= pivot and everything from u to r is >= pivot.
+            std::pair<RandomAccessIterator, bool> result{partition_hoare(l, u - 1, r, comp)};
+            result.second = result.second && alreadyPartitioned;
+            return result;
         }
-    } // namespace detail
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // partition_simd<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Skips the elements that are already on the correct side, like the Hoare loop, and hands
+        // the rest to the AVX-512 or AVX2 kernel. Falls back to partition_block when the CPU has
+        // neither.
+        template <typename RandomAccessIterator, typename Compare>
+        std::pair<RandomAccessIterator, bool> partition_simd(RandomAccessIterator first,
+                                                             RandomAccessIterator last,
+                                                             Compare comp)
+        {
+            using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            using std::swap;
+            constexpr bool descending{std::is_same<Compare, std::greater<T>>::value ||
+                                      std::is_same<Compare, std::greater<>>::value};
+            T *base{std::addressof(*first)};
+            T *r{base + (last - first - 1)};
+            const T pivot{*r};
+            T *l{base};
+            T *u{r};
+            while (l < u && comp(*l, pivot))
+            {
+                ++l;
+            }
+            while (l < u && comp(pivot, *(u - 1)))
+            {
+                --u;
+            }
+            if (l == u)
+            {
+                swap(*l, *r);
+                return {first + (l - base), true};
+            }
+            if (u - l < simd_partition_min_size)
+            {
+                return partition_hoare(first + (l - base), first + (u - base - 1), last - 1, comp);
+            }
+            T *mid{simd_partition<descending>(l, u, pivot)};
+            if (mid == nullptr)
+            {
+                return partition_block(first, last, comp);
+            }
+            swap(*mid, *r);
+            return {first + (mid - base), false};
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // partition_range<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Partitions [first, last - 1) around the pivot already stored at last - 1.
+        template <typename RandomAccessIterator, typename Compare>
+        std::pair<RandomAccessIterator, bool> partition_range(RandomAccessIterator first,
+                                                              RandomAccessIterator last,
+                                                              Compare comp)
+        {
+            using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            if constexpr (is_simd_partitionable<RandomAccessIterator, Compare>::value)
+            {
+                return partition_simd(first, last, comp);
+            }
+            else if constexpr (is_branchless_compare<T, Compare>::value)
+            {
+                return partition_block(first, last, comp);
+            }
+            else
+            {
+                return partition_hoare(first, last - 2, last - 1, comp);
+            }
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // partition_three_way<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Bentley-McIlroy partition of [first, last - 1) around the pivot stored at last - 1.
+        // Elements equal to the pivot are parked at both ends during the Hoare scan and swapped
+        // into the middle at the end. Returns the range of elements equal to the pivot, pivot
+        // included; everything before it is less and everything after it is greater.
+        template <typename RandomAccessIterator, typename Compare>
+        std::pair<RandomAccessIterator, RandomAccessIterator> partition_three_way(RandomAccessIterator first,
+                                                                                  RandomAccessIterator last,
+                                                                                  Compare comp)
+        {
+            using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+            using std::swap;
+            Diff r{last - first - 1};
+            // [0, p] and [q, r) hold elements equal to the pivot, (p, i) less and (j, q) greater.
+            Diff i{-1};
+            Diff j{r};
+            Diff p{-1};
+            Diff q{r};
+            while (true)
+            {
+                // The pivot stops the first scan.
+                while (comp(first[++i], first[r]))
+                {
+                }
+                while (comp(first[r], first[--j]))
+                {
+                    if (j == 0)
+                    {
+                        break;
+                    }
+                }
+                if (i >= j)
+                {
+                    break;
+                }
+                swap(first[i], first[j]);
+                count_swaps(comp, 1);
+                if (!comp(first[i], first[r]))
+                {
+                    ++p;
+                    if (p != i)
+                    {
+                        swap(first[p], first[i]);
+                        count_swaps(comp, 1);
+                    }
+                }
+                if (!comp(first[r], first[j]))
+                {
+                    --q;
+                    if (q != j)
+                    {
+                        swap(first[q], first[j]);
+                        count_swaps(comp, 1);
+                    }
+                }
+            }
+            // The scans stopped at an element that is not less than the pivot and now trades
+            // places with it. When that element is equal, it joins the ones parked at the end.
+            Diff parkedLast{r};
+            if (i != r)
+            {
+                if (!comp(first[r], first[i]))
+                {
+                    parkedLast = r + 1;
+                }
+                swap(first[i], first[r]);
+                count_swaps(comp, 1);
+            }
+            // Swap the parked elements with the nearest ones of the less and greater parts.
+            Diff lessCount{i - (p + 1)};
+            Diff leftCount{std::min(p + 1, lessCount)};
+            for (Diff k = 0; k < leftCount; ++k)
+            {
+                swap(first[k], first[i - 1 - k]);
+            }
+            // When the scan stopped at the first parked element or at the pivot itself, nothing
+            // greater is left between them.
+            Diff parkedFirst{std::max(q, i + 1)};
+            Diff parkedCount{std::max<Diff>(0, parkedLast - parkedFirst)};
+            Diff greaterCount{parkedFirst - (i + 1)};
+            Diff rightCount{std::min(parkedCount, greaterCount)};
+            for (Diff k = 0; k < rightCount; ++k)
+            {
+                swap(first[parkedLast - 1 - k], first[i + 1 + k]);
+            }
+            count_swaps(comp, leftCount + rightCount);
+            return {first + lessCount, first + (i + 1 + parkedCount)};
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // partition_pivot<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <typename RandomAccessIterator, typename Compare>
+        RandomAccessIterator partition_pivot(RandomAccessIterator first,
+                                             RandomAccessIterator last,
+                                             Compare comp)
+        {
+            move_pivot_to_last(first, last, comp);
+            // r is pivot
+            return partition_range(first, last, comp).first;
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // partition_stack<RandomAccessIterator>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Ranges waiting to be sorted by quick_sort and intro_sort_impl. Only the larger side of
+        // a partition is pushed while the loop continues with the smaller one, so every pushed
+        // range is at least twice as large as the one above it and the stack never holds more
+        // ranges than the difference type has bits.
+        template <typename RandomAccessIterator>
+        class partition_stack
+        {
+        public:
+            using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+
+            struct range
+            {
+                RandomAccessIterator first;
+                RandomAccessIterator last;
+                int depth;
+                int unbalanced;
+            };
+
+            bool empty() const
+            {
+                return size_ == 0;
+            }
+
+            void push(RandomAccessIterator first, RandomAccessIterator last, int depth, int unbalanced = 0)
+            {
+                assert(size_ < capacity);
+                ranges_[size_++] = range{first, last, depth, unbalanced};
+            }
+
+            range pop()
+            {
+                assert(size_ > 0);
+                return ranges_[--size_];
+            }
+
+            // Continues with the smaller side of the partition at i of [first, last) and pushes the
+            // larger one.
+            void split(RandomAccessIterator &first,
+                       RandomAccessIterator &last,
+                       RandomAccessIterator i,
+                       int depth,
+                       int unbalanced = 0)
+            {
+                split(first, last, i, i + 1, depth, unbalanced);
+            }
+
+            // Same for a three-way partition whose middle part [lower, upper) is finished.
+            void split(RandomAccessIterator &first,
+                       RandomAccessIterator &last,
+                       RandomAccessIterator lower,
+                       RandomAccessIterator upper,
+                       int depth,
+                       int unbalanced = 0)
+            {
+                if (lower - first < last - upper)
+                {
+                    push(upper, last, depth, unbalanced);
+                    last = lower;
+                }
+                else
+                {
+                    push(first, lower, depth, unbalanced);
+                    first = upper;
+                }
+            }
+
+        private:
+            static constexpr int capacity = std::numeric_limits<Diff>::digits;
+
+            range ranges_[capacity];
+            int size_{0};
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // depth_limit
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        inline int depth_limit(double n)
+        {
+            return 2 * static_cast<int>(std::log2(std::max(1.0, n)));
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // sort3<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <typename RandomAccessIterator, typename Compare>
+        void sort3(RandomAccessIterator a, RandomAccessIterator b, RandomAccessIterator c, Compare comp)
+        {
+            using std::swap;
+            if (comp(*b, *a))
+            {
+                swap(*a, *b);
+                count_swaps(comp, 1);
+            }
+            if (comp(*c, *b))
+            {
+                swap(*b, *c);
+                count_swaps(comp, 1);
+                if (comp(*b, *a))
+                {
+                    swap(*a, *b);
+                    count_swaps(comp, 1);
+                }
+            }
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // select_pivot<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Median-of-3 for small ranges and Tukey's ninther for large ones; the pivot ends up at
+        // last - 1. Returns true when the pivot is equal to one of the samples next to it in the
+        // last median-of-3.
+        template <typename RandomAccessIterator, typename Compare>
+        bool select_pivot(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+        {
+            using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+            using std::swap;
+            constexpr int nintherThreshold = 128;
+            Diff n{last - first};
+            if (n > nintherThreshold)
+            {
+                Diff half{n / 2};
+                sort3(first, first + half, last - 1, comp);
+                sort3(first + 1, first + (half - 1), last - 2, comp);
+                sort3(first + 2, first + (half + 1), last - 3, comp);
+                sort3(first + (half - 1), first + half, first + (half + 1), comp);
+                bool repeated{!comp(first[half - 1], first[half]) || !comp(first[half], first[half + 1])};
+                swap(first[half], *(last - 1));
+                count_swaps(comp, 1);
+                return repeated;
+            }
+            else
+            {
+                return move_pivot_to_last(first, last, comp);
+            }
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // partial_insertion_sort<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Same as insertion_sort, but gives up and returns false once more than a few elements
+        // had to be moved.
+        template <typename RandomAccessIterator, typename Compare>
+        bool partial_insertion_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+        {
+            using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+            constexpr Diff moveLimit = 8;
+            Diff moves{0};
+            if (first < last)
+            {
+                for (RandomAccessIterator i{first + 1}; i != last; ++i)
+                {
+                    if (comp(*i, *(i - 1)))
+                    {
+                        T value{std::move(*i)};
+                        RandomAccessIterator j{i - 1};
+                        RandomAccessIterator current{i};
+                        try
+                        {
+                            do
+                            {
+                                *current = std::move(*j);
+                                current = j;
+                                if (j == first)
+                                {
+                                    break;
+                                }
+                                --j;
+                            } while (comp(value, *j));
+
+                            *current = std::move(value);
+                        }
+                        catch (...)
+                        {
+                            *current = std::move(value);
+                            throw;
+                        }
+                        count_moves(comp, (i - current) + 2);
+                        moves += i - current;
+                        if (moves > moveLimit)
+                        {
+                            return false;
+                        }
+                    }
+                }
+            }
+            return true;
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // break_patterns<RandomAccessIterator>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Deterministically swaps a few elements of a side that ended up too small, so that the
+        // next pivot of that side is drawn from different positions. comp is only used to count
+        // the swaps.
+        template <typename RandomAccessIterator, typename Compare>
+        void break_patterns(RandomAccessIterator first, RandomAccessIterator last, const Compare &comp)
+        {
+            using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+            using std::swap;
+            constexpr int threshold = 16;
+            constexpr int nintherThreshold = 128;
+            Diff n{last - first};
+            if (n > threshold)
+            {
+                Diff quarter{n / 4};
+                swap(first[0], first[quarter]);
+                swap(*(last - 1), *(last - quarter));
+                count_swaps(comp, 2);
+                if (n > nintherThreshold)
+                {
+                    swap(first[1], first[quarter + 1]);
+                    swap(first[2], first[quarter + 2]);
+                    swap(*(last - 2), *(last - (quarter + 1)));
+                    swap(*(last - 3), *(last - (quarter + 2)));
+                    count_swaps(comp, 4);
+                }
+            }
+        }
+    } // namespace detail
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // quick_sort<RandomAccessIterator>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename RandomAccessIterator>
+    void quick_sort(RandomAccessIterator first, RandomAccessIterator last)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        quick_sort(first, last, std::less<T>{});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // quick_sort<RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename RandomAccessIterator, typename Compare>
+    void quick_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+    {
+        quick_sort<detail::leaf_threshold<RandomAccessIterator, Compare>>(first, last, comp);
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // quick_sort<Threshold, RandomAccessIterator>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <int Threshold, typename RandomAccessIterator>
+    void quick_sort(RandomAccessIterator first, RandomAccessIterator last)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        quick_sort<Threshold>(first, last, std::less<T>{});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // quick_sort<Threshold, RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Ranges of at most Threshold elements are finished by a sorting network or insertion_sort.
+    // Picks its pivots like intro_sort and breaks up the patterns behind an unbalanced split, but
+    // never falls back to heap_sort.
+    template <int Threshold, typename RandomAccessIterator, typename Compare>
+    void quick_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+    {
+        using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+        static_assert(Threshold >= 2, "quick_sort needs at least 3 elements to partition");
+        detail::partition_stack<RandomAccessIterator> pending;
+        int depth{0};
+        while (true)
+        {
+            Diff n{last - first};
+            if (n <= Threshold)
+            {
+                {
+                    detail::leaf_timer<Compare> timer{comp};
+                    detail::small_sort(first, last, comp);
+                }
+                if (pending.empty())
+                {
+                    return;
+                }
+                typename detail::partition_stack<RandomAccessIterator>::range next{pending.pop()};
+                first = next.first;
+                last = next.last;
+                depth = next.depth;
+            }
+            else if (detail::select_pivot(first, last, comp))
+            {
+                // Keys equal to the pivot are finished here instead of being partitioned again.
+                std::pair<RandomAccessIterator, RandomAccessIterator> equal{
+                    detail::partition_three_way(first, last, comp)};
+                detail::count_partition(comp, depth, equal.first - first, last - equal.second);
+                ++depth;
+                pending.split(first, last, equal.first, equal.second, depth);
+            }
+            else
+            {
+                RandomAccessIterator i{detail::partition_range(first, last, comp).first};
+                Diff leftSize{i - first};
+                Diff rightSize{last - (i + 1)};
+                detail::count_partition(comp, depth, leftSize, rightSize);
+                // An unbalanced split comes from a pattern in the input, such as a descending range
+                // after the SIMD partition has rearranged it; moving a few elements changes the
+                // next samples.
+                if (leftSize < n / 8 || rightSize < n / 8)
+                {
+                    detail::break_patterns(first, i, comp);
+                    detail::break_patterns(i + 1, last, comp);
+                }
+                ++depth;
+                pending.split(first, last, i, depth);
+            }
+        }
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // quick_sort<RandomAccessIterator, Compare, Statistics>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // comp is wrapped to count the comparisons, so the leaves are always finished by
+    // insertion_sort and the partition is never vectorized.
+    template <typename RandomAccessIterator, typename Compare, typename Statistics>
+    void quick_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp, Statistics &stats)
+    {
+        static_assert(detail::is_stats_policy<Statistics>::value, "Statistics must be sort_stats or no_stats");
+        if constexpr (std::is_same<Statistics, sort_stats>::value)
+        {
+            quick_sort(first, last, detail::counting_compare<Compare>{comp, stats});
+        }
+        else
+        {
+            quick_sort(first, last, comp);
+        }
+    }
+
+    namespace detail
+    {
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // intro_sort_impl<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Sorts [first, last) with depthLimit unbalanced partitions, which leave more than 7 / 8
+        // of the range on one side, to spend before a range goes to heap_sort. The others shrink
+        // the range geometrically, so counting them too would only send inputs that keep
+        // splitting 80 / 20, such as concatenated sorted runs, to heap_sort. Iterative, so the
+        // call stack stays flat whatever the input.
+        template <typename RandomAccessIterator,
+                  typename Compare,
+                  int Threshold = leaf_threshold<RandomAccessIterator, Compare>>
+        void intro_sort_impl(RandomAccessIterator first,
+                             RandomAccessIterator last,
+                             Compare comp,
+                             int depthLimit)
+        {
+            using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+            static_assert(Threshold >= 2, "intro_sort needs at least 3 elements to partition");
+            partition_stack<RandomAccessIterator> pending;
+            // Number of partitions above the current range, and how many of them were unbalanced.
+            int depth{0};
+            int unbalancedDepth{0};
+            while (true)
+            {
+                Diff n{last - first};
+                bool sorted{true};
+                if (n <= Threshold)
+                {
+                    leaf_timer<Compare> timer{comp};
+                    small_sort(first, last, comp);
+                }
+                else if (unbalancedDepth >= depthLimit)
+                {
+                    count_heap_fallback(comp);
+                    heap_sort<fallback_heap>(first, last, comp);
+                }
+                else if (select_pivot(first, last, comp))
+                {
+                    // Keys equal to the pivot are finished here instead of being partitioned
+                    // again, so k distinct keys take O(n k) time at most.
+                    std::pair<RandomAccessIterator, RandomAccessIterator> equal{partition_three_way(first, last, comp)};
+                    count_partition(comp, depth, equal.first - first, last - equal.second);
+                    ++depth;
+                    unbalancedDepth += std::max(equal.first - first, last - equal.second) > n - n / 8;
+                    pending.split(first, last, equal.first, equal.second, depth, unbalancedDepth);
+                    sorted = false;
+                }
+                else
+                {
+                    std::pair<RandomAccessIterator, bool> result{partition_range(first, last, comp)};
+                    RandomAccessIterator i{result.first};
+                    Diff leftSize{i - first};
+                    Diff rightSize{last - (i + 1)};
+                    count_partition(comp, depth, leftSize, rightSize);
+                    bool unbalanced{leftSize < n / 8 || rightSize < n / 8};
+                    if (unbalanced)
+                    {
+                        break_patterns(first, i, comp);
+                        break_patterns(i + 1, last, comp);
+                    }
+                    // When the partition pass found the range already in order, both sides are
+                    // usually finished by partial_insertion_sort.
+                    sorted = !unbalanced && result.second &&
+                             partial_insertion_sort(first, i, comp) &&
+                             partial_insertion_sort(i + 1, last, comp);
+                    if (!sorted)
+                    {
+                        ++depth;
+                        unbalancedDepth += unbalanced;
+                        pending.split(first, last, i, depth, unbalancedDepth);
+                    }
+                }
+                if (sorted)
+                {
+                    if (pending.empty())
+                    {
+                        return;
+                    }
+                    typename partition_stack<RandomAccessIterator>::range next{pending.pop()};
+                    first = next.first;
+                    last = next.last;
+                    depth = next.depth;
+                    unbalancedDepth = next.unbalanced;
+                }
+            }
+        }
+    } // namespace detail
+
+    namespace detail
+    {
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // is_radix_sortable<T>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <typename T>
+        struct is_radix_sortable
+            : std::integral_constant<bool,
+                                     (std::is_integral<T>::value && !std::is_same<T, bool>::value &&
+                                      (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8)) ||
+                                         (std::is_floating_point<T>::value && std::numeric_limits<T>::is_iec559 &&
+                                          (sizeof(T) == 4 || sizeof(T) == 8))>
+        {
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // is_default_compare<T, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <typename T, typename Compare>
+        struct is_default_compare
+            : std::integral_constant<bool,
+                                     std::is_same<Compare, std::less<T>>::value ||
+                                         std::is_same<Compare, std::less<>>::value>
+        {
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // radix_key_type<Size>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <std::size_t Size>
+        struct radix_key_type;
+
+        template <>
+        struct radix_key_type<1>
+        {
+            using type = std::uint8_t;
+        };
+
+        template <>
+        struct radix_key_type<2>
+        {
+            using type = std::uint16_t;
+        };
+
+        template <>
+        struct radix_key_type<4>
+        {
+            using type = std::uint32_t;
+        };
+
+        template <>
+        struct radix_key_type<8>
+        {
+            using type = std::uint64_t;
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // radix_key<T, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Maps a value to an unsigned integer whose natural order matches comp. Signed integers
+        // get their sign bit flipped; IEEE-754 values get all bits flipped when negative and only
+        // the sign bit flipped otherwise.
+        template <typename T, typename Compare>
+        typename radix_key_type<sizeof(T)>::type radix_key(T value, Compare)
+        {
+            using Key = typename radix_key_type<sizeof(T)>::type;
+            constexpr Key signBit{static_cast<Key>(Key{1} << (sizeof(Key) * 8 - 1))};
+            Key key;
+            std::memcpy(&key, &value, sizeof(T));
+            if constexpr (std::is_floating_point<T>::value)
+            {
+                key = (key & signBit) ? static_cast<Key>(~key) : static_cast<Key>(key | signBit);
+            }
+            else if constexpr (std::is_signed<T>::value)
+            {
+                key = static_cast<Key>(key ^ signBit);
+            }
+            if constexpr (std::is_same<Compare, std::greater<T>>::value ||
+                          std::is_same<Compare, std::greater<>>::value)
+            {
+                key = static_cast<Key>(~key);
+            }
+            return key;
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // radix_digit<T, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <typename T, typename Compare>
+        std::size_t radix_digit(const T &value, int shift, Compare comp)
+        {
+            return static_cast<std::size_t>((radix_key(value, comp) >> shift) & 0xff);
+        }
+
+        // (key, index) entries built by intro_sort_by_key are ordered by their key.
+        template <typename T, typename Compare>
+        std::size_t radix_digit(const std::pair<T, std::size_t> &entry, int shift, Compare comp)
+        {
+            return radix_digit(entry.first, shift, comp);
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // radix_width<T>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <typename T>
+        struct radix_width : std::integral_constant<int, static_cast<int>(sizeof(T))>
+        {
+        };
+
+        template <typename T>
+        struct radix_width<std::pair<T, std::size_t>> : radix_width<T>
+        {
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // radix_scatter<InputIterator, OutputIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <typename InputIterator, typename OutputIterator, typename Compare>
+        void radix_scatter(InputIterator first,
+                           InputIterator last,
+                           OutputIterator out,
+                           int shift,
+                           const std::size_t (&counts)[256],
+                           Compare comp)
+        {
+            std::size_t offsets[256];
+            std::size_t sum{0};
+            for (int d = 0; d < 256; ++d)
+            {
+                offsets[d] = sum;
+                sum += counts[d];
+            }
+            for (InputIterator i{first}; i != last; ++i)
+            {
+                out[offsets[radix_digit(*i, shift, comp)]++] = std::move(*i);
+            }
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // radix_sort_lsd_buffered<RandomAccessIterator, BufferIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Least significant digit first, one byte per pass, through buffer, which holds n
+        // elements. The histograms of every byte are built in a single pass, and bytes that are
+        // the same in all keys are skipped.
+        template <typename RandomAccessIterator, typename BufferIterator, typename Compare>
+        void radix_sort_lsd_buffered(RandomAccessIterator first,
+                                     RandomAccessIterator last,
+                                     BufferIterator buffer,
+                                     Compare comp)
+        {
+            using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            constexpr int bytes = radix_width<T>::value;
+            std::size_t n{static_cast<std::size_t>(last - first)};
+            BufferIterator bufferLast{buffer + static_cast<std::ptrdiff_t>(n)};
+            std::size_t counts[bytes][256] = {};
+            for (RandomAccessIterator i{first}; i != last; ++i)
+            {
+                for (int b = 0; b < bytes; ++b)
+                {
+                    ++counts[b][radix_digit(*i, b * 8, comp)];
+                }
+            }
+            bool inBuffer{false};
+            for (int b = 0; b < bytes; ++b)
+            {
+                std::size_t shared{inBuffer ? radix_digit(buffer[0], b * 8, comp)
+                                            : radix_digit(*first, b * 8, comp)};
+                if (counts[b][shared] == n)
+                {
+                    continue;
+                }
+                if (inBuffer)
+                {
+                    radix_scatter(buffer, bufferLast, first, b * 8, counts[b], comp);
+                }
+                else
+                {
+                    radix_scatter(first, last, buffer, b * 8, counts[b], comp);
+                }
+                inBuffer = !inBuffer;
+            }
+            if (inBuffer)
+            {
+                std::move(buffer, bufferLast, first);
+            }
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // radix_sort_lsd<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Takes the buffer from workspace, or allocates it when there is none.
+        template <typename RandomAccessIterator, typename Compare>
+        void radix_sort_lsd(RandomAccessIterator first,
+                            RandomAccessIterator last,
+                            Compare comp,
+                            sort_workspace *workspace = nullptr)
+        {
+            using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            std::size_t n{static_cast<std::size_t>(last - first)};
+            if (n < 2)
+            {
+                return;
+            }
+            if (workspace != nullptr)
+            {
+                workspace_array<T> buffer{*workspace, n};
+                buffer.fill();
+                radix_sort_lsd_buffered(first, last, buffer.begin(), comp);
+            }
+            else
+            {
+                std::vector<T> buffer(n);
+                radix_sort_lsd_buffered(first, last, buffer.begin(), comp);
+            }
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // radix_sort_msd<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // American flag sort: permutes each bucket into place by following cycles, so no buffer
+        // is needed. Small buckets are finished by intro_sort_impl.
+        template <typename RandomAccessIterator, typename Compare>
+        void radix_sort_msd(RandomAccessIterator first, RandomAccessIterator last, Compare comp, int shift)
+        {
+            using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+            using std::swap;
+            constexpr int threshold = 64;
+            while (true)
+            {
+                Diff n{last - first};
+                if (n <= threshold)
+                {
+                    intro_sort_impl(first, last, comp, depth_limit(static_cast<double>(n)));
+                    return;
+                }
+                std::size_t counts[256] = {};
+                for (RandomAccessIterator i{first}; i != last; ++i)
+                {
+                    ++counts[radix_digit(*i, shift, comp)];
+                }
+                if (counts[radix_digit(*first, shift, comp)] == static_cast<std::size_t>(n))
+                {
+                    if (shift == 0)
+                    {
+                        return;
+                    }
+                    shift -= 8;
+                    continue;
+                }
+                Diff heads[256];
+                Diff tails[256];
+                Diff sum{0};
+                for (int d = 0; d < 256; ++d)
+                {
+                    heads[d] = sum;
+                    sum += static_cast<Diff>(counts[d]);
+                    tails[d] = sum;
+                }
+                for (int d = 0; d < 256; ++d)
+                {
+                    while (heads[d] < tails[d])
+                    {
+                        T value{std::move(first[heads[d]])};
+                        std::size_t digit{radix_digit(value, shift, comp)};
+                        while (digit != static_cast<std::size_t>(d))
+                        {
+                            swap(value, first[heads[digit]++]);
+                            digit = radix_digit(value, shift, comp);
+                        }
+                        first[heads[d]++] = std::move(value);
+                    }
+                }
+                if (shift > 0)
+                {
+                    Diff begin{0};
+                    for (int d = 0; d < 256; ++d)
+                    {
+                        Diff end{begin + static_cast<Diff>(counts[d])};
+                        if (end - begin > 1)
+                        {
+                            radix_sort_msd(first + begin, first + end, comp, shift - 8);
+                        }
+                        begin = end;
+                    }
+                }
+                return;
+            }
+        }
+    } // namespace detail
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // radix_sort<RandomAccessIterator>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename RandomAccessIterator>
+    void radix_sort(RandomAccessIterator first, RandomAccessIterator last)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        radix_sort(first, last, std::less<T>{});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // radix_sort<RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Compare must be std::less or std::greater. Allocates a buffer of last - first elements.
+    template <typename RandomAccessIterator, typename Compare>
+    void radix_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        static_assert(detail::is_radix_sortable<T>::value, "radix_sort requires an integral or IEEE-754 value_type");
+        static_assert(detail::is_branchless_compare<T, Compare>::value, "radix_sort requires std::less or std::greater");
+        detail::radix_sort_lsd(first, last, comp);
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // radix_sort<RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Takes the buffer from workspace instead of allocating it.
+    template <typename RandomAccessIterator, typename Compare>
+    void radix_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp, sort_workspace &workspace)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        static_assert(detail::is_radix_sortable<T>::value, "radix_sort requires an integral or IEEE-754 value_type");
+        static_assert(detail::is_branchless_compare<T, Compare>::value, "radix_sort requires std::less or std::greater");
+        detail::radix_sort_lsd(first, last, comp, &workspace);
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // radix_sort_in_place<RandomAccessIterator>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename RandomAccessIterator>
+    void radix_sort_in_place(RandomAccessIterator first, RandomAccessIterator last)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        radix_sort_in_place(first, last, std::less<T>{});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // radix_sort_in_place<RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Compare must be std::less or std::greater. Does not allocate.
+    template <typename RandomAccessIterator, typename Compare>
+    void radix_sort_in_place(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        static_assert(detail::is_radix_sortable<T>::value, "radix_sort_in_place requires an integral or IEEE-754 value_type");
+        static_assert(detail::is_branchless_compare<T, Compare>::value, "radix_sort_in_place requires std::less or std::greater");
+        detail::radix_sort_msd(first, last, comp, static_cast<int>(sizeof(T) * 8 - 8));
+    }
+
+    namespace detail
+    {
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // gallop_forward<RandomAccessIterator, Predicate>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Returns the partition point of pred, probing first[0], first[1], first[3], first[7], ...
+        // before the binary search, so short answers near first are found in O(log k).
+        template <typename RandomAccessIterator, typename Predicate>
+        RandomAccessIterator gallop_forward(RandomAccessIterator first, RandomAccessIterator last, Predicate pred)
+        {
+            using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+            Diff n{last - first};
+            Diff lo{0};
+            Diff probe{0};
+            while (probe < n && pred(first[probe]))
+            {
+                lo = probe + 1;
+                probe = 2 * probe + 1;
+            }
+            return std::partition_point(first + lo, first + std::min(probe, n), pred);
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // gallop_backward<RandomAccessIterator, Predicate>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Same as gallop_forward, but probes from the end of the range.
+        template <typename RandomAccessIterator, typename Predicate>
+        RandomAccessIterator gallop_backward(RandomAccessIterator first, RandomAccessIterator last, Predicate pred)
+        {
+            using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+            Diff n{last - first};
+            Diff hi{n};
+            Diff probe{0};
+            while (probe < n && !pred(first[n - 1 - probe]))
+            {
+                hi = n - 1 - probe;
+                probe = 2 * probe + 1;
+            }
+            Diff lo{probe < n ? n - probe : 0};
+            return std::partition_point(first + lo, first + hi, pred);
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // merge_from_buffer<RandomAccessIterator, BufferIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Merges the sorted elements of [bufferFirst, bufferLast), moved out of [middle, last),
+        // into sorted [first, middle) from the back. Each buffered element gallops back over the
+        // prefix to its place, and the prefix elements it passes move in one block, so a short
+        // buffer costs few comparisons however long the prefix is.
+        template <typename RandomAccessIterator, typename BufferIterator, typename Compare>
+        void merge_from_buffer(RandomAccessIterator first,
+                               RandomAccessIterator middle,
+                               RandomAccessIterator last,
+                               BufferIterator bufferFirst,
+                               BufferIterator bufferLast,
+                               Compare comp)
+        {
+            RandomAccessIterator cursor{middle};
+            RandomAccessIterator dest{last};
+            BufferIterator next{bufferLast};
+            try
+            {
+                while (next != bufferFirst)
+                {
+                    const auto &value{*(next - 1)};
+                    RandomAccessIterator position{
+                        gallop_backward(first, cursor, [&comp, &value](const auto &x) { return !comp(value, x); })};
+                    dest = std::move_backward(position, cursor, dest);
+                    cursor = position;
+                    *--dest = std::move(*--next);
+                }
+            }
+            catch (...)
+            {
+                // [cursor, dest) is the hole, exactly as long as what is left in the buffer.
+                std::move(bufferFirst, next, cursor);
+                throw;
+            }
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // merge_sorted_tail<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Merges sorted [middle, last) into sorted [first, middle) through a buffer as large as
+        // the part of the tail that has to move, taken from workspace when there is one.
+        template <typename RandomAccessIterator, typename Compare>
+        void merge_sorted_tail(RandomAccessIterator first,
+                               RandomAccessIterator middle,
+                               RandomAccessIterator last,
+                               Compare comp,
+                               sort_workspace *workspace)
+        {
+            using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            if (first == middle || middle == last || !comp(*middle, *(middle - 1)))
+            {
+                return;
+            }
+            // Tail elements not ordered before the largest prefix element are already in place,
+            // and so are the prefix elements not ordered after the smallest tail element.
+            last = std::lower_bound(middle, last, *(middle - 1), comp);
+            first = std::upper_bound(first, middle, *middle, comp);
+            if (workspace != nullptr)
+            {
+                workspace_array<T> buffer{*workspace, static_cast<std::size_t>(last - middle)};
+                for (RandomAccessIterator i{middle}; i != last; ++i)
+                {
+                    buffer.emplace_back(std::move(*i));
+                }
+                merge_from_buffer(first, middle, last, buffer.begin(), buffer.end(), comp);
+            }
+            else
+            {
+                std::vector<T> buffer(std::make_move_iterator(middle), std::make_move_iterator(last));
+                merge_from_buffer(first, middle, last, buffer.begin(), buffer.end(), comp);
+            }
+        }
+
+        template <int Threshold, typename RandomAccessIterator, typename Compare>
+        void intro_sort_entry(RandomAccessIterator first,
+                              RandomAccessIterator last,
+                              Compare comp,
+                              sort_workspace *workspace);
+
+        // sort_presorted sorts and merges the tail when it is at most 1 / presorted_tail_divisor
+        // of the range. Even a tail of half the range costs about half of sorting everything.
+        constexpr int presorted_tail_divisor = 2;
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // sort_presorted<Threshold, RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Finds the leading run in one pass, reversing it when it is strictly descending. When
+        // the run covers the whole range or at least minimumRun elements, as after appending to
+        // a sorted array, sorts only the rest and merges it in, and returns true. Otherwise
+        // returns false and the range still has to be sorted.
+        template <int Threshold, typename RandomAccessIterator, typename Compare>
+        bool sort_presorted(RandomAccessIterator first,
+                            RandomAccessIterator last,
+                            Compare comp,
+                            sort_workspace *workspace,
+                            typename std::iterator_traits<RandomAccessIterator>::difference_type minimumRun)
+        {
+            RandomAccessIterator middle{first + 1};
+            if (comp(*middle, *first))
+            {
+                while (middle != last && comp(*middle, *(middle - 1)))
+                {
+                    ++middle;
+                }
+                if (middle != last && middle - first < minimumRun)
+                {
+                    return false;
+                }
+                std::reverse(first, middle);
+            }
+            while (middle != last && !comp(*middle, *(middle - 1)))
+            {
+                ++middle;
+            }
+            if (middle == last)
+            {
+                return true;
+            }
+            if (middle - first < minimumRun)
+            {
+                return false;
+            }
+            intro_sort_entry<Threshold>(middle, last, comp, workspace);
+            try
+            {
+                merge_sorted_tail(first, middle, last, comp, workspace);
+            }
+            catch (const std::bad_alloc &)
+            {
+                return false;
+            }
+            return true;
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // intro_sort_entry<Threshold, RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Input that is mostly a sorted run is finished by sort_presorted. The radix sort buffer
+        // comes from workspace when there is one.
+        template <int Threshold, typename RandomAccessIterator, typename Compare>
+        void intro_sort_entry(RandomAccessIterator first,
+                              RandomAccessIterator last,
+                              Compare comp,
+                              sort_workspace *workspace)
+        {
+            using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            if (last - first > Threshold &&
+                sort_presorted<Threshold>(first, last, comp, workspace, last - first - (last - first) / presorted_tail_divisor))
+            {
+                return;
+            }
+            if constexpr (is_radix_sortable<T>::value && is_default_compare<T, Compare>::value)
+            {
+                constexpr int radixThreshold = 1 << 11;
+                if (last - first >= radixThreshold)
+                {
+                    try
+                    {
+                        radix_sort_lsd(first, last, comp, workspace);
+                    }
+                    catch (const std::bad_alloc &)
+                    {
+                        radix_sort_msd(first, last, comp, static_cast<int>(sizeof(T) * 8 - 8));
+                    }
+                    return;
+                }
+            }
+            int depthLimit = depth_limit(static_cast<double>(last - first));
+            intro_sort_impl<RandomAccessIterator, Compare, Threshold>(first, last, comp, depthLimit);
+        }
+    } // namespace detail
 
     //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
     // intro_sort<RandomAccessIterator>
@@ -322,8 +1907,245 @@ namespace omoteura
     template <typename RandomAccessIterator, typename Compare>
     void intro_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
     {
-        int depthLimit = 2 * static_cast<int>(std::log2(
-                                 std::max(1.0, static_cast<double>(last - first))));
-        detail::intro_sort_impl(first, last, comp, depthLimit);
+        intro_sort<detail::leaf_threshold<RandomAccessIterator, Compare>>(first, last, comp);
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // intro_sort<Threshold, RandomAccessIterator>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <int Threshold, typename RandomAccessIterator>
+    void intro_sort(RandomAccessIterator first, RandomAccessIterator last)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        intro_sort<Threshold>(first, last, std::less<T>{});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // intro_sort<Threshold, RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Ranges of at most Threshold elements are finished by a sorting network or insertion_sort.
+    template <int Threshold, typename RandomAccessIterator, typename Compare>
+    void intro_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+    {
+        detail::intro_sort_entry<Threshold>(first, last, comp, nullptr);
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // intro_sort<RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Takes the buffer for radix sort from workspace instead of allocating it.
+    template <typename RandomAccessIterator, typename Compare>
+    void intro_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp, sort_workspace &workspace)
+    {
+        intro_sort<detail::leaf_threshold<RandomAccessIterator, Compare>>(first, last, comp, workspace);
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // intro_sort<Threshold, RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <int Threshold, typename RandomAccessIterator, typename Compare>
+    void intro_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp, sort_workspace &workspace)
+    {
+        detail::intro_sort_entry<Threshold>(first, last, comp, &workspace);
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // intro_sort<RandomAccessIterator, Compare, Statistics>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // comp is wrapped to count the comparisons, so this always takes the comparison-based path:
+    // no radix sort, sorting networks or vectorized partition.
+    template <typename RandomAccessIterator, typename Compare, typename Statistics>
+    void intro_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp, Statistics &stats)
+    {
+        static_assert(detail::is_stats_policy<Statistics>::value, "Statistics must be sort_stats or no_stats");
+        if constexpr (std::is_same<Statistics, sort_stats>::value)
+        {
+            intro_sort(first, last, detail::counting_compare<Compare>{comp, stats});
+        }
+        else
+        {
+            intro_sort(first, last, comp);
+        }
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // adaptive_sort<RandomAccessIterator>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename RandomAccessIterator>
+    void adaptive_sort(RandomAccessIterator first, RandomAccessIterator last)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        adaptive_sort(first, last, std::less<T>{});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // adaptive_sort<RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Sorts a sorted array with unsorted elements appended: finds the leading run in one pass,
+    // reversing it when it is descending, sorts the rest with intro_sort and merges it in through
+    // a buffer as large as the rest. intro_sort does the same by itself when the run covers at
+    // least half of the range; this does it whatever the run's length.
+    template <typename RandomAccessIterator, typename Compare>
+    void adaptive_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+    {
+        constexpr int threshold = detail::leaf_threshold<RandomAccessIterator, Compare>;
+        if (last - first > threshold && detail::sort_presorted<threshold>(first, last, comp, nullptr, 0))
+        {
+            return;
+        }
+        intro_sort(first, last, comp);
+    }
+
+    namespace detail
+    {
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // apply_permutation<RandomAccessIterator>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Moves first[source[k]] to first[k] for every k < n by following cycles. source is used
+        // as scratch and left as the identity permutation.
+        template <typename RandomAccessIterator>
+        void apply_permutation(RandomAccessIterator first, std::size_t *source, std::size_t n)
+        {
+            using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                if (source[i] != i)
+                {
+                    T value{std::move(first[i])};
+                    std::size_t j{i};
+                    try
+                    {
+                        while (source[j] != i)
+                        {
+                            std::size_t next{source[j]};
+                            first[j] = std::move(first[next]);
+                            source[j] = j;
+                            j = next;
+                        }
+                        first[j] = std::move(value);
+                        source[j] = j;
+                    }
+                    catch (...)
+                    {
+                        first[j] = std::move(value);
+                        throw;
+                    }
+                }
+            }
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // sort_key_entries<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Sorts (key, index) entries by key, with radix sort when the key allows it. The radix
+        // sort buffer comes from workspace when there is one.
+        template <typename RandomAccessIterator, typename Compare>
+        void sort_key_entries(RandomAccessIterator first,
+                              RandomAccessIterator last,
+                              Compare comp,
+                              sort_workspace *workspace = nullptr)
+        {
+            using Entry = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            using Key = typename Entry::first_type;
+            auto compareEntries = [&comp](const Entry &a, const Entry &b) { return comp(a.first, b.first); };
+            constexpr int threshold = leaf_threshold<RandomAccessIterator, decltype(compareEntries)>;
+            if constexpr (is_radix_sortable<Key>::value && is_branchless_compare<Key, Compare>::value)
+            {
+                try
+                {
+                    radix_sort_lsd(first, last, comp, workspace);
+                }
+                catch (const std::bad_alloc &)
+                {
+                    intro_sort_entry<threshold>(first, last, compareEntries, workspace);
+                }
+            }
+            else
+            {
+                // The merge buffer of a sorted prefix comes from workspace as well.
+                intro_sort_entry<threshold>(first, last, compareEntries, workspace);
+            }
+        }
+    } // namespace detail
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // intro_sort_by_key<RandomAccessIterator, Projection>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename RandomAccessIterator, typename Projection>
+    void intro_sort_by_key(RandomAccessIterator first, RandomAccessIterator last, Projection proj)
+    {
+        using Reference = typename std::iterator_traits<RandomAccessIterator>::reference;
+        using Key = std::decay_t<std::invoke_result_t<Projection &, Reference>>;
+        intro_sort_by_key(first, last, proj, std::less<Key>{});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // intro_sort_by_key<RandomAccessIterator, Projection, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Extracts every key once into a compact (key, index) array, sorts that array with
+    // intro_sort, and then permutes the elements in place. comp compares keys, not elements.
+    template <typename RandomAccessIterator, typename Projection, typename Compare>
+    void intro_sort_by_key(RandomAccessIterator first, RandomAccessIterator last, Projection proj, Compare comp)
+    {
+        using Reference = typename std::iterator_traits<RandomAccessIterator>::reference;
+        using Key = std::decay_t<std::invoke_result_t<Projection &, Reference>>;
+        using Entry = std::pair<Key, std::size_t>;
+        std::size_t n{static_cast<std::size_t>(last - first)};
+        if (n < 2)
+        {
+            return;
+        }
+        std::vector<Entry> entries;
+        entries.reserve(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            entries.emplace_back(std::invoke(proj, first[i]), i);
+        }
+        detail::sort_key_entries(entries.begin(), entries.end(), comp);
+        std::vector<std::size_t> source;
+        source.reserve(n);
+        for (const Entry &entry : entries)
+        {
+            source.push_back(entry.second);
+        }
+        entries.clear();
+        entries.shrink_to_fit();
+        detail::apply_permutation(first, source.data(), n);
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // intro_sort_by_key<RandomAccessIterator, Projection, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Takes the (key, index) array, the radix sort buffer and the permutation from workspace
+    // instead of allocating them.
+    template <typename RandomAccessIterator, typename Projection, typename Compare>
+    void intro_sort_by_key(RandomAccessIterator first,
+                           RandomAccessIterator last,
+                           Projection proj,
+                           Compare comp,
+                           sort_workspace &workspace)
+    {
+        using Reference = typename std::iterator_traits<RandomAccessIterator>::reference;
+        using Key = std::decay_t<std::invoke_result_t<Projection &, Reference>>;
+        using Entry = std::pair<Key, std::size_t>;
+        std::size_t n{static_cast<std::size_t>(last - first)};
+        if (n < 2)
+        {
+            return;
+        }
+        // The entries are in use together with either the radix sort buffer or the permutation.
+        workspace.reserve_bytes(2 * (n * sizeof(Entry) + alignof(std::max_align_t)));
+        detail::workspace_array<Entry> entries{workspace, n};
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            entries.emplace_back(std::invoke(proj, first[i]), i);
+        }
+        detail::sort_key_entries(entries.begin(), entries.end(), comp, &workspace);
+        detail::workspace_array<std::size_t> source{workspace, n};
+        for (const Entry &entry : entries)
+        {
+            source.emplace_back(entry.second);
+        }
+        detail::apply_permutation(first, source.begin(), n);
     }
 } // namespace omoteura
@@ -0,0 +1,599 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// parallel_intro_sort.h
+// Copyright (c) 2025 ozk
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "intro_sort.h"
+
+namespace omoteura
+{
+    template <typename RandomAccessIterator, typename Compare>
+    void parallel_intro_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp);
+    template <typename RandomAccessIterator, typename Compare>
+    void parallel_intro_sort(RandomAccessIterator first,
+                             RandomAccessIterator last,
+                             Compare comp,
+                             unsigned threads);
+
+    namespace detail
+    {
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // work_stealing_queue<Task>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // The owner pushes and pops at the back; other workers steal the oldest (largest) task
+        // from the front.
+        template <typename Task>
+        class work_stealing_queue
+        {
+        public:
+            void push(Task task)
+            {
+                std::lock_guard<std::mutex> lock{mutex_};
+                tasks_.push_back(std::move(task));
+            }
+
+            bool pop(Task &task)
+            {
+                std::lock_guard<std::mutex> lock{mutex_};
+                if (tasks_.empty())
+                {
+                    return false;
+                }
+                task = std::move(tasks_.back());
+                tasks_.pop_back();
+                return true;
+            }
+
+            bool steal(Task &task)
+            {
+                std::lock_guard<std::mutex> lock{mutex_};
+                if (tasks_.empty())
+                {
+                    return false;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+                return true;
+            }
+
+        private:
+            std::deque<Task> tasks_;
+            std::mutex mutex_;
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // partition_around<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Partitions [first, last) around *pivot, which lies outside the range, and returns where
+        // the elements not less than the pivot start. second is true when nothing had to move.
+        template <typename RandomAccessIterator, typename Compare>
+        std::pair<RandomAccessIterator, bool> partition_around(RandomAccessIterator first,
+                                                               RandomAccessIterator last,
+                                                               RandomAccessIterator pivot,
+                                                               Compare comp)
+        {
+            using std::swap;
+            while (first != last && comp(*first, *pivot))
+            {
+                ++first;
+            }
+            while (first != last && comp(*pivot, *(last - 1)))
+            {
+                --last;
+            }
+            if (last - first <= 1)
+            {
+                return {first, true};
+            }
+            if constexpr (is_simd_partitionable<RandomAccessIterator, Compare>::value)
+            {
+                using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+                constexpr bool descending{std::is_same<Compare, std::greater<T>>::value ||
+                                          std::is_same<Compare, std::greater<>>::value};
+                if (last - first >= simd_partition_min_size)
+                {
+                    T *base{std::addressof(*first)};
+                    if (T *mid{simd_partition<descending>(base, base + (last - first), *pivot)})
+                    {
+                        return {first + (mid - base), false};
+                    }
+                }
+            }
+            // Both ends are on the wrong side here.
+            while (true)
+            {
+                swap(*first, *(last - 1));
+                count_swaps(comp, 1);
+                ++first;
+                --last;
+                while (first != last && comp(*first, *pivot))
+                {
+                    ++first;
+                }
+                while (first != last && comp(*pivot, *(last - 1)))
+                {
+                    --last;
+                }
+                if (last - first <= 1)
+                {
+                    return {first, false};
+                }
+            }
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // parallel_intro_sort_scheduler<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <typename RandomAccessIterator, typename Compare>
+        class parallel_intro_sort_scheduler
+        {
+        public:
+            using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+
+            // Subranges at or below this size are sorted by the task that produced them.
+            static constexpr Diff cutoff = 1 << 14;
+            // Subranges at least this large and larger than an even share of the input are
+            // partitioned by several workers; below that there are enough subranges to go round.
+            static constexpr Diff parallel_partition_min_size = 1 << 18;
+            // Each worker of a parallel partition takes at least this many elements.
+            static constexpr Diff partition_chunk_size = 1 << 16;
+
+            parallel_intro_sort_scheduler(Compare comp, unsigned threads)
+                : comp_(comp)
+            {
+                queues_.reserve(threads);
+                for (unsigned i = 0; i < threads; ++i)
+                {
+                    queues_.push_back(std::make_unique<work_stealing_queue<task>>());
+                }
+            }
+
+            void run(RandomAccessIterator first, RandomAccessIterator last)
+            {
+                total_ = last - first;
+                push(0, task{first, last, depth_limit(static_cast<double>(total_))});
+
+                std::vector<std::thread> workers;
+                workers.reserve(queues_.size() - 1);
+                for (std::size_t i = 1; i < queues_.size(); ++i)
+                {
+                    try
+                    {
+                        workers.emplace_back([this, i] { work(i); });
+                    }
+                    catch (const std::system_error &)
+                    {
+                        // Keep going with the workers we already have.
+                        break;
+                    }
+                }
+                work(0);
+                for (std::thread &worker : workers)
+                {
+                    worker.join();
+                }
+
+                if (error_)
+                {
+                    std::rethrow_exception(error_);
+                }
+            }
+
+        private:
+            // One partition of a large subrange shared by several workers. Every chunk of
+            // [first, last - 1) is partitioned around the pivot at last - 1 on its own, then the
+            // elements on the wrong side of the final boundary are swapped across it in pieces.
+            // Whoever finishes the last chunk or piece starts the next step.
+            struct partition_job
+            {
+                RandomAccessIterator first;
+                RandomAccessIterator last;
+                int depthLimit;
+                int chunks;
+                int pieces;
+                // Where the elements not less than the pivot start in each chunk.
+                std::vector<RandomAccessIterator> middles;
+                RandomAccessIterator boundary;
+                // Runs of elements not less than the pivot left of the boundary, and of elements
+                // not greater than it right of the boundary. Both hold misplaced elements.
+                std::vector<std::pair<RandomAccessIterator, RandomAccessIterator>> wrongLeft;
+                std::vector<std::pair<RandomAccessIterator, RandomAccessIterator>> wrongRight;
+                Diff misplaced;
+                std::atomic<int> remaining;
+                std::atomic<bool> moved{false};
+            };
+
+            enum class step
+            {
+                sort,
+                partition_chunk,
+                swap_piece
+            };
+
+            struct task
+            {
+                task() = default;
+
+                task(RandomAccessIterator first,
+                     RandomAccessIterator last,
+                     int depthLimit,
+                     step kind = step::sort,
+                     std::shared_ptr<partition_job> job = nullptr,
+                     int piece = 0)
+                    : first(first), last(last), depthLimit(depthLimit), kind(kind), job(std::move(job)), piece(piece)
+                {
+                }
+
+                RandomAccessIterator first;
+                RandomAccessIterator last;
+                int depthLimit{0};
+                step kind{step::sort};
+                std::shared_ptr<partition_job> job;
+                int piece{0};
+            };
+
+            // Counts the task as pending before it can be taken, and wakes one idle worker.
+            void push(std::size_t index, task current)
+            {
+                pending_.fetch_add(1);
+                try
+                {
+                    queues_[index]->push(current);
+                }
+                catch (...)
+                {
+                    pending_.fetch_sub(1);
+                    throw;
+                }
+                {
+                    std::lock_guard<std::mutex> lock{idleMutex_};
+                    queued_.fetch_add(1);
+                }
+                idle_.notify_one();
+            }
+
+            // Workers without a task sleep until one is pushed or the last pending task is done.
+            void work(std::size_t index)
+            {
+                std::size_t count{queues_.size()};
+                task current{};
+                while (true)
+                {
+                    bool found{queues_[index]->pop(current)};
+                    for (std::size_t k = 1; !found && k < count; ++k)
+                    {
+                        found = queues_[(index + k) % count]->steal(current);
+                    }
+                    if (found)
+                    {
+                        queued_.fetch_sub(1);
+                        execute(current, index);
+                        if (pending_.fetch_sub(1) == 1)
+                        {
+                            {
+                                std::lock_guard<std::mutex> lock{idleMutex_};
+                            }
+                            idle_.notify_all();
+                        }
+                        continue;
+                    }
+                    std::unique_lock<std::mutex> lock{idleMutex_};
+                    idle_.wait(lock, [this] { return pending_.load() == 0 || queued_.load() > 0; });
+                    if (pending_.load() == 0)
+                    {
+                        return;
+                    }
+                }
+            }
+
+            // Partitions the way intro_sort_impl does, with the same pivot selection, three-way
+            // partition of repeated pivots and pattern breaking, and hands the right side of
+            // every partition to the queue until the rest is small enough to sort here. The
+            // first partitions, which would otherwise leave the other workers waiting, are split
+            // among them.
+            void execute(task current, std::size_t index)
+            {
+                if (failed_.load())
+                {
+                    return;
+                }
+                try
+                {
+                    if (current.kind == step::partition_chunk)
+                    {
+                        partition_chunk(current.job, current.piece, index);
+                        return;
+                    }
+                    if (current.kind == step::swap_piece)
+                    {
+                        swap_piece(current.job, current.piece, index);
+                        return;
+                    }
+                    while (current.last - current.first > cutoff && current.depthLimit > 0)
+                    {
+                        Diff n{current.last - current.first};
+                        RandomAccessIterator lower;
+                        RandomAccessIterator upper;
+                        bool unbalanced;
+                        if (select_pivot(current.first, current.last, comp_))
+                        {
+                            std::pair<RandomAccessIterator, RandomAccessIterator> equal{
+                                partition_three_way(current.first, current.last, comp_)};
+                            lower = equal.first;
+                            upper = equal.second;
+                            unbalanced = std::max(lower - current.first, current.last - upper) > n - n / 8;
+                        }
+                        else if (n >= parallel_partition_min_size && n > total_ / static_cast<Diff>(queues_.size()))
+                        {
+                            start_partition(current, index);
+                            return;
+                        }
+                        else
+                        {
+                            std::pair<RandomAccessIterator, bool> result{partition_range(current.first, current.last, comp_)};
+                            RandomAccessIterator i{result.first};
+                            unbalanced = i - current.first < n / 8 || current.last - (i + 1) < n / 8;
+                            if (unbalanced)
+                            {
+                                break_patterns(current.first, i, comp_);
+                                break_patterns(i + 1, current.last, comp_);
+                            }
+                            if (!unbalanced && result.second && partial_insertion_sort(current.first, i, comp_) &&
+                                partial_insertion_sort(i + 1, current.last, comp_))
+                            {
+                                return;
+                            }
+                            lower = i;
+                            upper = i + 1;
+                        }
+                        // Only unbalanced partitions count toward the limit, as in intro_sort_impl.
+                        current.depthLimit -= unbalanced;
+                        push(index, task{upper, current.last, current.depthLimit});
+                        current.last = lower;
+                    }
+                    intro_sort_impl(current.first, current.last, comp_, current.depthLimit);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock{errorMutex_};
+                    if (!error_)
+                    {
+                        error_ = std::current_exception();
+                    }
+                    failed_.store(true);
+                }
+            }
+
+            // Splits the partition of current, whose pivot is already at last - 1, into one chunk
+            // per worker and partitions the first chunk here.
+            void start_partition(const task &current, std::size_t index)
+            {
+                std::shared_ptr<partition_job> job{std::make_shared<partition_job>()};
+                job->first = current.first;
+                job->last = current.last;
+                job->depthLimit = current.depthLimit;
+                job->chunks = static_cast<int>(std::min<Diff>(static_cast<Diff>(queues_.size()),
+                                                              (current.last - current.first - 1) / partition_chunk_size));
+                job->middles.resize(job->chunks);
+                job->remaining.store(job->chunks);
+                for (int chunk = job->chunks - 1; chunk > 0; --chunk)
+                {
+                    push(index, task{current.first, current.last, current.depthLimit, step::partition_chunk, job, chunk});
+                }
+                partition_chunk(job, 0, index);
+            }
+
+            static RandomAccessIterator chunk_begin(const partition_job &job, Diff size, int chunk)
+            {
+                return job.first + size * chunk / job.chunks;
+            }
+
+            void partition_chunk(const std::shared_ptr<partition_job> &job, int chunk, std::size_t index)
+            {
+                Diff size{job->last - job->first - 1};
+                std::pair<RandomAccessIterator, bool> result{partition_around(
+                    chunk_begin(*job, size, chunk), chunk_begin(*job, size, chunk + 1), job->last - 1, comp_)};
+                job->middles[chunk] = result.first;
+                if (!result.second)
+                {
+                    job->moved.store(true);
+                }
+                if (job->remaining.fetch_sub(1) == 1)
+                {
+                    plan_swaps(job, index);
+                }
+            }
+
+            // Finds the boundary between the two sides and the misplaced runs of every chunk, and
+            // swaps them across it in parallel when there are enough of them.
+            void plan_swaps(const std::shared_ptr<partition_job> &job, std::size_t index)
+            {
+                Diff size{job->last - job->first - 1};
+                Diff leftSize{0};
+                for (int chunk = 0; chunk < job->chunks; ++chunk)
+                {
+                    leftSize += job->middles[chunk] - chunk_begin(*job, size, chunk);
+                }
+                job->boundary = job->first + leftSize;
+                job->misplaced = 0;
+                for (int chunk = 0; chunk < job->chunks; ++chunk)
+                {
+                    RandomAccessIterator begin{chunk_begin(*job, size, chunk)};
+                    RandomAccessIterator end{chunk_begin(*job, size, chunk + 1)};
+                    RandomAccessIterator middle{job->middles[chunk]};
+                    if (middle < job->boundary && middle < end)
+                    {
+                        job->wrongLeft.emplace_back(middle, std::min(end, job->boundary));
+                        job->misplaced += job->wrongLeft.back().second - middle;
+                    }
+                    if (job->boundary < middle && begin < middle)
+                    {
+                        job->wrongRight.emplace_back(std::max(begin, job->boundary), middle);
+                    }
+                }
+                Diff pieces{std::min<Diff>(static_cast<Diff>(queues_.size()), job->misplaced / partition_chunk_size)};
+                if (pieces < 2)
+                {
+                    swap_misplaced(*job, 0, job->misplaced);
+                    finish_partition(job, index);
+                    return;
+                }
+                job->pieces = static_cast<int>(pieces);
+                job->remaining.store(job->pieces);
+                for (int piece = job->pieces - 1; piece > 0; --piece)
+                {
+                    push(index, task{job->first, job->last, job->depthLimit, step::swap_piece, job, piece});
+                }
+                swap_piece(job, 0, index);
+            }
+
+            void swap_piece(const std::shared_ptr<partition_job> &job, int piece, std::size_t index)
+            {
+                swap_misplaced(*job, job->misplaced * piece / job->pieces, job->misplaced * (piece + 1) / job->pieces);
+                if (job->remaining.fetch_sub(1) == 1)
+                {
+                    finish_partition(job, index);
+                }
+            }
+
+            // Swaps the misplaced elements numbered [begin, end) on the left with those with the
+            // same numbers on the right.
+            void swap_misplaced(partition_job &job, Diff begin, Diff end)
+            {
+                auto seek = [begin](const std::vector<std::pair<RandomAccessIterator, RandomAccessIterator>> &runs,
+                                    std::size_t &run,
+                                    RandomAccessIterator &position) {
+                    Diff skip{begin};
+                    run = 0;
+                    while (run < runs.size() && runs[run].second - runs[run].first <= skip)
+                    {
+                        skip -= runs[run].second - runs[run].first;
+                        ++run;
+                    }
+                    if (run < runs.size())
+                    {
+                        position = runs[run].first + skip;
+                    }
+                };
+                std::size_t l{0};
+                std::size_t r{0};
+                RandomAccessIterator i{job.boundary};
+                RandomAccessIterator j{job.boundary};
+                seek(job.wrongLeft, l, i);
+                seek(job.wrongRight, r, j);
+                for (Diff count = end - begin; count > 0;)
+                {
+                    Diff length{std::min({count, job.wrongLeft[l].second - i, job.wrongRight[r].second - j})};
+                    j = std::swap_ranges(i, i + length, j);
+                    i += length;
+                    count_swaps(comp_, static_cast<std::size_t>(length));
+                    count -= length;
+                    if (i == job.wrongLeft[l].second && ++l < job.wrongLeft.size())
+                    {
+                        i = job.wrongLeft[l].first;
+                    }
+                    if (j == job.wrongRight[r].second && ++r < job.wrongRight.size())
+                    {
+                        j = job.wrongRight[r].first;
+                    }
+                }
+            }
+
+            // Moves the pivot to the boundary and queues both sides, as execute does after a
+            // serial partition.
+            void finish_partition(const std::shared_ptr<partition_job> &job, std::size_t index)
+            {
+                using std::swap;
+                RandomAccessIterator i{job->boundary};
+                swap(*i, *(job->last - 1));
+                count_swaps(comp_, 1);
+                Diff n{job->last - job->first};
+                bool unbalanced{i - job->first < n / 8 || job->last - (i + 1) < n / 8};
+                if (unbalanced)
+                {
+                    break_patterns(job->first, i, comp_);
+                    break_patterns(i + 1, job->last, comp_);
+                }
+                if (!unbalanced && !job->moved.load() && job->misplaced == 0 &&
+                    partial_insertion_sort(job->first, i, comp_) && partial_insertion_sort(i + 1, job->last, comp_))
+                {
+                    return;
+                }
+                int depthLimit{job->depthLimit - unbalanced};
+                push(index, task{i + 1, job->last, depthLimit});
+                push(index, task{job->first, i, depthLimit});
+            }
+
+            Compare comp_;
+            std::vector<std::unique_ptr<work_stealing_queue<task>>> queues_;
+            Diff total_{0};
+            std::atomic<std::size_t> pending_{0};
+            // Tasks in the queues. A thief can take a task before it is counted, so this may
+            // briefly drop below zero.
+            std::atomic<std::ptrdiff_t> queued_{0};
+            std::mutex idleMutex_;
+            std::condition_variable idle_;
+            std::atomic<bool> failed_{false};
+            std::mutex errorMutex_;
+            std::exception_ptr error_;
+        };
+    } // namespace detail
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // parallel_intro_sort<RandomAccessIterator>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename RandomAccessIterator>
+    void parallel_intro_sort(RandomAccessIterator first, RandomAccessIterator last)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        parallel_intro_sort(first, last, std::less<T>{});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // parallel_intro_sort<RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename RandomAccessIterator, typename Compare>
+    void parallel_intro_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+    {
+        parallel_intro_sort(first, last, comp, std::thread::hardware_concurrency());
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // parallel_intro_sort<RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // threads includes the calling thread; 0 or 1 sorts on the calling thread only.
+    template <typename RandomAccessIterator, typename Compare>
+    void parallel_intro_sort(RandomAccessIterator first,
+                             RandomAccessIterator last,
+                             Compare comp,
+                             unsigned threads)
+    {
+        using Scheduler = detail::parallel_intro_sort_scheduler<RandomAccessIterator, Compare>;
+        if (threads <= 1 || last - first <= Scheduler::cutoff)
+        {
+            intro_sort(first, last, comp);
+        }
+        else
+        {
+            Scheduler scheduler{comp, threads};
+            scheduler.run(first, last);
+        }
+    }
+} // namespace omoteura
@@ -0,0 +1,600 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// parallel_merge_sort.h
+// Copyright (c) 2025 ozk
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "intro_sort.h"
+#include "parallel_intro_sort.h"
+
+namespace omoteura
+{
+    template <typename RandomAccessIterator, typename Compare>
+    void parallel_merge_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp);
+    template <typename RandomAccessIterator, typename Compare>
+    void parallel_merge_sort(RandomAccessIterator first,
+                             RandomAccessIterator last,
+                             Compare comp,
+                             unsigned threads);
+
+    namespace detail
+    {
+        // Chunks are sized to about this many bytes, roughly the L2 cache of one core, so that
+        // intro_sort never leaves the cache.
+        constexpr std::size_t merge_chunk_bytes = 1 << 20;
+
+        // At most this many chunks are merged; larger inputs get larger chunks instead.
+        constexpr std::ptrdiff_t max_merge_ways = 1024;
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // sorted_run<T>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <typename T>
+        struct sorted_run
+        {
+            T *first;
+            T *last;
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // multiway_split<T, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Stores in split[i] how many elements of runs[i] are among the first rank elements of
+        // the merged runs, with equal elements ordered by run and then by position. Each round
+        // takes the weighted median of the middles of the remaining windows as a candidate,
+        // ranks it with one binary search per run and discards at least a quarter of what is
+        // left, so it takes O(k log^2 n) comparisons for k runs.
+        template <typename T, typename Compare>
+        void multiway_split(const std::vector<sorted_run<T>> &runs,
+                            std::ptrdiff_t rank,
+                            std::ptrdiff_t *split,
+                            Compare comp)
+        {
+            struct candidate
+            {
+                std::size_t run;
+                std::ptrdiff_t position;
+                std::ptrdiff_t weight;
+            };
+
+            std::size_t k{runs.size()};
+            std::vector<std::ptrdiff_t> lo(k, 0);
+            std::vector<std::ptrdiff_t> hi(k);
+            for (std::size_t i = 0; i < k; ++i)
+            {
+                hi[i] = runs[i].last - runs[i].first;
+            }
+            std::vector<candidate> candidates;
+            candidates.reserve(k);
+            std::vector<std::ptrdiff_t> before(k);
+            while (true)
+            {
+                candidates.clear();
+                std::ptrdiff_t remaining{0};
+                for (std::size_t i = 0; i < k; ++i)
+                {
+                    if (lo[i] < hi[i])
+                    {
+                        candidates.push_back(candidate{i, lo[i] + (hi[i] - lo[i]) / 2, hi[i] - lo[i]});
+                        remaining += hi[i] - lo[i];
+                    }
+                }
+                if (candidates.empty())
+                {
+                    std::copy(lo.begin(), lo.end(), split);
+                    return;
+                }
+
+                std::sort(candidates.begin(), candidates.end(), [&runs, &comp](const candidate &a, const candidate &b) {
+                    const T &x{runs[a.run].first[a.position]};
+                    const T &y{runs[b.run].first[b.position]};
+                    return comp(x, y) || (!comp(y, x) && a.run < b.run);
+                });
+                std::size_t median{0};
+                for (std::ptrdiff_t weight{candidates[0].weight}; 2 * weight < remaining;)
+                {
+                    weight += candidates[++median].weight;
+                }
+                std::size_t pivotRun{candidates[median].run};
+                std::ptrdiff_t pivotPosition{candidates[median].position};
+                const T &pivot{runs[pivotRun].first[pivotPosition]};
+
+                // Elements of earlier runs that are equal to the pivot come before it, those of
+                // later runs after it.
+                std::ptrdiff_t pivotRank{0};
+                for (std::size_t i = 0; i < k; ++i)
+                {
+                    if (i < pivotRun)
+                    {
+                        before[i] = std::upper_bound(runs[i].first, runs[i].last, pivot, comp) - runs[i].first;
+                    }
+                    else if (i > pivotRun)
+                    {
+                        before[i] = std::lower_bound(runs[i].first, runs[i].last, pivot, comp) - runs[i].first;
+                    }
+                    else
+                    {
+                        before[i] = pivotPosition;
+                    }
+                    pivotRank += before[i];
+                }
+
+                if (pivotRank == rank)
+                {
+                    std::copy(before.begin(), before.end(), split);
+                    return;
+                }
+                if (pivotRank < rank)
+                {
+                    // The pivot and everything before it are in.
+                    for (std::size_t i = 0; i < k; ++i)
+                    {
+                        lo[i] = std::max(lo[i], before[i]);
+                    }
+                    lo[pivotRun] = pivotPosition + 1;
+                }
+                else
+                {
+                    // The pivot and everything after it are out.
+                    for (std::size_t i = 0; i < k; ++i)
+                    {
+                        hi[i] = std::min(hi[i], before[i]);
+                    }
+                }
+            }
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // loser_tree<Player>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // A tournament over one player per leaf in which every internal node keeps the player
+        // that lost the match played there, so replacing the winner replays only the path from
+        // its leaf to the root, one comparison per level. less(a, b) is true when a must come
+        // out before b. Ties go to the lower leaf when the tree is built and to the current
+        // winner when it is replayed, so merges through the tree are stable.
+        template <typename Player>
+        class loser_tree
+        {
+        public:
+            // Plays every match among players, where players[i] sits at leaf i. If less throws,
+            // the tree is left empty.
+            template <typename Less>
+            void build(std::vector<Player> players, Less less)
+            {
+                clear();
+                int k{static_cast<int>(players.size())};
+                if (k == 0)
+                {
+                    return;
+                }
+                // Leaves are the nodes k to 2k - 1; node 0 is unused.
+                std::vector<entry> winners(2 * static_cast<std::size_t>(k));
+                std::vector<entry> losers(static_cast<std::size_t>(k));
+                for (int i = 0; i < k; ++i)
+                {
+                    winners[k + i] = entry{std::move(players[i]), i};
+                }
+                for (int node = k - 1; node > 0; --node)
+                {
+                    entry &a{winners[2 * node]};
+                    entry &b{winners[2 * node + 1]};
+                    bool swapped{less(b.player, a.player)};
+                    winners[node] = std::move(swapped ? b : a);
+                    losers[node] = std::move(swapped ? a : b);
+                }
+                nodes_ = std::move(losers);
+                winner_ = std::move(winners[1]);
+                size_ = k;
+            }
+
+            // Replays the matches of the winner after its player has been changed in place.
+            template <typename Less>
+            void replay(Less less)
+            {
+                for (int node = (winner_.leaf + size_) / 2; node > 0; node /= 2)
+                {
+                    if constexpr (std::is_trivially_copyable<entry>::value)
+                    {
+                        // Selects instead of branches: the outcome of each match is random.
+                        entry loser{nodes_[node]};
+                        bool swapped{less(loser.player, winner_.player)};
+                        nodes_[node] = swapped ? winner_ : loser;
+                        winner_ = swapped ? loser : winner_;
+                    }
+                    else if (less(nodes_[node].player, winner_.player))
+                    {
+                        std::swap(nodes_[node], winner_);
+                    }
+                }
+            }
+
+            // Calls f(player, leaf) for every player.
+            template <typename Function>
+            void for_each(Function f)
+            {
+                for (int node = 1; node < size_; ++node)
+                {
+                    f(nodes_[node].player, nodes_[node].leaf);
+                }
+                if (size_ > 0)
+                {
+                    f(winner_.player, winner_.leaf);
+                }
+            }
+
+            void clear()
+            {
+                nodes_.clear();
+                size_ = 0;
+            }
+
+            int size() const
+            {
+                return size_;
+            }
+
+            Player &winner()
+            {
+                return winner_.player;
+            }
+
+            const Player &winner() const
+            {
+                return winner_.player;
+            }
+
+            int winner_leaf() const
+            {
+                return winner_.leaf;
+            }
+
+        private:
+            struct entry
+            {
+                Player player;
+                int leaf;
+            };
+
+            std::vector<entry> nodes_;
+            entry winner_{};
+            int size_{0};
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // multiway_merge<T, RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Moves the elements of the sorted runs to dest in order, choosing each one with a loser
+        // tree whose players are the next element of each run. If comp throws, the rest of the
+        // runs is moved to dest unmerged, so dest is still filled with every element.
+        template <typename T, typename RandomAccessIterator, typename Compare>
+        void multiway_merge(std::vector<sorted_run<T>> runs, RandomAccessIterator dest, Compare comp)
+        {
+            auto empty = [](const sorted_run<T> &r) { return r.first == r.last; };
+            runs.erase(std::remove_if(runs.begin(), runs.end(), empty), runs.end());
+            auto less = [&comp](T *a, T *b) { return comp(*a, *b); };
+            loser_tree<T *> tree;
+            // Writes the positions of the players back to runs.
+            auto settle = [&runs, &tree] {
+                tree.for_each([&runs](T *head, int leaf) { runs[leaf].first = head; });
+                tree.clear();
+            };
+
+            try
+            {
+                std::vector<T *> heads;
+                // Every run in the tree is non-empty, so matches need no end checks. When the
+                // winning run runs out, the tree is rebuilt without it.
+                while (runs.size() > 1)
+                {
+                    heads.clear();
+                    for (const sorted_run<T> &r : runs)
+                    {
+                        heads.push_back(r.first);
+                    }
+                    tree.build(heads, less);
+
+                    while (true)
+                    {
+                        T *&head{tree.winner()};
+                        *dest = std::move(*head);
+                        ++dest;
+                        if (++head == runs[tree.winner_leaf()].last)
+                        {
+                            break;
+                        }
+                        tree.replay(less);
+                    }
+                    int exhausted{tree.winner_leaf()};
+                    settle();
+                    runs.erase(runs.begin() + exhausted);
+                }
+                if (!runs.empty())
+                {
+                    std::move(runs[0].first, runs[0].last, dest);
+                }
+            }
+            catch (...)
+            {
+                settle();
+                for (sorted_run<T> &r : runs)
+                {
+                    dest = std::move(r.first, r.last, dest);
+                }
+                throw;
+            }
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // parallel_merge_sorter<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Moves cache-sized chunks into a buffer and sorts each there with intro_sort, then
+        // merges all chunks back into the range. The output is cut into one segment per thread,
+        // and multiway_split finds where each segment starts in every chunk, so the threads
+        // merge independently. Each element crosses memory twice, whatever the size of the
+        // range.
+        template <typename RandomAccessIterator, typename Compare>
+        class parallel_merge_sorter
+        {
+        public:
+            using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+
+            // Ranges at or below this size are sorted by intro_sort on the calling thread.
+            static constexpr Diff cutoff = 1 << 16;
+
+            parallel_merge_sorter(RandomAccessIterator first, RandomAccessIterator last, Compare comp, unsigned threads)
+                : first_(first), size_(last - first), comp_(comp), threads_(threads)
+            {
+                Diff cacheChunk{std::max<Diff>(static_cast<Diff>(merge_chunk_bytes / sizeof(T)), 1)};
+                chunkSize_ = std::min<Diff>(cacheChunk, (size_ + threads - 1) / threads);
+                chunkSize_ = std::max<Diff>(chunkSize_, (size_ + max_merge_ways - 1) / max_merge_ways);
+                chunkCount_ = (size_ + chunkSize_ - 1) / chunkSize_;
+                segmentCount_ = std::min<Diff>(threads, size_);
+            }
+
+            parallel_merge_sorter(const parallel_merge_sorter &) = delete;
+            parallel_merge_sorter &operator=(const parallel_merge_sorter &) = delete;
+
+            ~parallel_merge_sorter()
+            {
+                if (buffer_ != nullptr)
+                {
+                    for (Diff c = 0; c < chunkCount_; ++c)
+                    {
+                        if (constructed_[c])
+                        {
+                            std::destroy(buffer_ + chunk_begin(c), buffer_ + chunk_end(c));
+                        }
+                    }
+                    std::allocator<T>{}.deallocate(buffer_, static_cast<std::size_t>(size_));
+                }
+            }
+
+            // Returns false when there is no memory for the buffer.
+            bool allocate()
+            {
+                try
+                {
+                    constructed_.assign(static_cast<std::size_t>(chunkCount_), 0);
+                    splits_.resize(static_cast<std::size_t>((segmentCount_ + 1) * chunkCount_));
+                    buffer_ = std::allocator<T>{}.allocate(static_cast<std::size_t>(size_));
+                }
+                catch (const std::bad_alloc &)
+                {
+                    return false;
+                }
+                return true;
+            }
+
+            void run()
+            {
+                try
+                {
+                    in_parallel(chunkCount_, [this](Diff c) { sort_chunk(c); });
+                    for (Diff c = 0; c < chunkCount_; ++c)
+                    {
+                        runs_.push_back(sorted_run<T>{buffer_ + chunk_begin(c), buffer_ + chunk_end(c)});
+                        splits_[static_cast<std::size_t>(segmentCount_ * chunkCount_ + c)] = chunk_end(c) - chunk_begin(c);
+                    }
+                    in_parallel(segmentCount_, [this](Diff s) { find_split(s); });
+                }
+                catch (...)
+                {
+                    // Nothing has been merged yet, so moving the chunks back restores every
+                    // element.
+                    for (Diff c = 0; c < chunkCount_; ++c)
+                    {
+                        if (constructed_[c])
+                        {
+                            std::move(buffer_ + chunk_begin(c), buffer_ + chunk_end(c), first_ + chunk_begin(c));
+                        }
+                    }
+                    throw;
+                }
+                in_parallel(segmentCount_, [this](Diff s) { merge_segment(s); });
+            }
+
+        private:
+            Diff chunk_begin(Diff c) const
+            {
+                return c * chunkSize_;
+            }
+
+            Diff chunk_end(Diff c) const
+            {
+                return std::min(size_, (c + 1) * chunkSize_);
+            }
+
+            Diff segment_begin(Diff s) const
+            {
+                return size_ / segmentCount_ * s + size_ % segmentCount_ * s / segmentCount_;
+            }
+
+            std::ptrdiff_t *split_of(Diff s)
+            {
+                return splits_.data() + s * chunkCount_;
+            }
+
+            // Runs body(0) to body(count - 1) on up to threads_ threads, the calling thread
+            // included, and rethrows the first exception once all of them have finished.
+            template <typename Body>
+            void in_parallel(Diff count, Body body)
+            {
+                std::atomic<Diff> next{0};
+                std::mutex errorMutex;
+                std::exception_ptr error;
+                auto work = [&next, &errorMutex, &error, count, &body] {
+                    try
+                    {
+                        for (Diff i{next.fetch_add(1)}; i < count; i = next.fetch_add(1))
+                        {
+                            body(i);
+                        }
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock{errorMutex};
+                        if (!error)
+                        {
+                            error = std::current_exception();
+                        }
+                    }
+                };
+
+                std::vector<std::thread> workers;
+                unsigned extra{static_cast<unsigned>(std::min<Diff>(threads_, count)) - 1};
+                workers.reserve(extra);
+                for (unsigned i = 0; i < extra; ++i)
+                {
+                    try
+                    {
+                        workers.emplace_back(work);
+                    }
+                    catch (const std::system_error &)
+                    {
+                        // Keep going with the workers we already have.
+                        break;
+                    }
+                }
+                work();
+                for (std::thread &worker : workers)
+                {
+                    worker.join();
+                }
+
+                if (error)
+                {
+                    std::rethrow_exception(error);
+                }
+            }
+
+            void sort_chunk(Diff c)
+            {
+                T *chunk{buffer_ + chunk_begin(c)};
+                T *chunkLast{std::uninitialized_move(first_ + chunk_begin(c), first_ + chunk_end(c), chunk)};
+                constructed_[static_cast<std::size_t>(c)] = 1;
+                intro_sort(chunk, chunkLast, comp_);
+            }
+
+            // Segment 0 starts at the beginning of every chunk; segment s computes where
+            // segment s + 1 starts.
+            void find_split(Diff s)
+            {
+                if (s + 1 < segmentCount_)
+                {
+                    multiway_split(runs_, segment_begin(s + 1), split_of(s + 1), comp_);
+                }
+            }
+
+            void merge_segment(Diff s)
+            {
+                std::vector<sorted_run<T>> runs{runs_};
+                const std::ptrdiff_t *from{split_of(s)};
+                const std::ptrdiff_t *to{split_of(s + 1)};
+                for (Diff c = 0; c < chunkCount_; ++c)
+                {
+                    runs[c].last = runs[c].first + to[c];
+                    runs[c].first += from[c];
+                }
+                multiway_merge(std::move(runs), first_ + segment_begin(s), comp_);
+            }
+
+            RandomAccessIterator first_;
+            Diff size_;
+            Compare comp_;
+            unsigned threads_;
+            Diff chunkSize_{0};
+            Diff chunkCount_{0};
+            Diff segmentCount_{0};
+            T *buffer_{nullptr};
+            std::vector<char> constructed_;
+            std::vector<sorted_run<T>> runs_;
+            // Row s holds where segment s starts in each chunk.
+            std::vector<std::ptrdiff_t> splits_;
+        };
+    } // namespace detail
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // parallel_merge_sort<RandomAccessIterator>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename RandomAccessIterator>
+    void parallel_merge_sort(RandomAccessIterator first, RandomAccessIterator last)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        parallel_merge_sort(first, last, std::less<T>{});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // parallel_merge_sort<RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename RandomAccessIterator, typename Compare>
+    void parallel_merge_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+    {
+        parallel_merge_sort(first, last, comp, std::thread::hardware_concurrency());
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // parallel_merge_sort<RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // For ranges much larger than the last-level cache. Needs a buffer as large as the range and
+    // falls back to parallel_intro_sort when it cannot be allocated. threads includes the
+    // calling thread; 0 or 1 sorts on the calling thread only.
+    template <typename RandomAccessIterator, typename Compare>
+    void parallel_merge_sort(RandomAccessIterator first,
+                             RandomAccessIterator last,
+                             Compare comp,
+                             unsigned threads)
+    {
+        using Sorter = detail::parallel_merge_sorter<RandomAccessIterator, Compare>;
+        if (threads <= 1 || last - first <= Sorter::cutoff)
+        {
+            intro_sort(first, last, comp);
+            return;
+        }
+        Sorter sorter{first, last, comp, threads};
+        if (sorter.allocate())
+        {
+            sorter.run();
+        }
+        else
+        {
+            parallel_intro_sort(first, last, comp, threads);
+        }
+    }
+} // namespace omoteura
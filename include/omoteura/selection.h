@@ -0,0 +1,242 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// selection.h
+// Copyright (c) 2025 ozk
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+#include "intro_sort.h"
+
+namespace omoteura
+{
+    template <typename RandomAccessIterator, typename Compare>
+    void nth_element(RandomAccessIterator first,
+                     RandomAccessIterator nth,
+                     RandomAccessIterator last,
+                     Compare comp);
+    template <typename RandomAccessIterator, typename Compare>
+    void partial_sort(RandomAccessIterator first,
+                      RandomAccessIterator middle,
+                      RandomAccessIterator last,
+                      Compare comp);
+    template <typename RandomAccessIterator, typename Compare>
+    RandomAccessIterator top_k(RandomAccessIterator first,
+                               RandomAccessIterator last,
+                               typename std::iterator_traits<RandomAccessIterator>::difference_type k,
+                               Compare comp);
+
+    namespace detail
+    {
+        // Ranges of at most this many elements are finished by insertion_sort.
+        constexpr int select_threshold = 16;
+
+        // partial_sort keeps a heap of the first k elements while k * heap_select_ratio <= n
+        // and selects with nth_element otherwise. The vectorized partition moves the crossover
+        // to much smaller k.
+        template <typename RandomAccessIterator, typename Compare>
+        constexpr int heap_select_ratio = is_simd_partitionable<RandomAccessIterator, Compare>::value ? 2048 : 128;
+
+        template <typename RandomAccessIterator, typename Compare>
+        void introselect(RandomAccessIterator first,
+                         RandomAccessIterator nth,
+                         RandomAccessIterator last,
+                         Compare comp,
+                         int depthLimit);
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // median_of_medians<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Moves the median of the medians of groups of five to last - 1. At least 30% of the
+        // range is then on each side of the pivot, which bounds introselect to linear time.
+        template <typename RandomAccessIterator, typename Compare>
+        void median_of_medians(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+        {
+            using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+            using std::swap;
+            Diff groups{(last - first) / 5};
+            for (Diff g = 0; g < groups; ++g)
+            {
+                RandomAccessIterator group{first + 5 * g};
+                insertion_sort(group, group + 5, comp);
+                // Position g lies in a group that has already been visited.
+                swap(first[g], group[2]);
+            }
+            RandomAccessIterator median{first + groups / 2};
+            introselect(first, median, first + groups, comp, 0);
+            swap(*median, *(last - 1));
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // introselect<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Quickselect on the partition used by intro_sort. Once depthLimit partitions have been
+        // spent, pivots come from median_of_medians instead of the ninther.
+        template <typename RandomAccessIterator, typename Compare>
+        void introselect(RandomAccessIterator first,
+                         RandomAccessIterator nth,
+                         RandomAccessIterator last,
+                         Compare comp,
+                         int depthLimit)
+        {
+            while (last - first > select_threshold)
+            {
+                if (depthLimit > 0)
+                {
+                    select_pivot(first, last, comp);
+                    --depthLimit;
+                }
+                else
+                {
+                    median_of_medians(first, last, comp);
+                }
+                RandomAccessIterator i{partition_range(first, last, comp).first};
+                if (i == nth)
+                {
+                    return;
+                }
+                if (nth < i)
+                {
+                    last = i;
+                }
+                else
+                {
+                    first = i + 1;
+                }
+            }
+            insertion_sort(first, last, comp);
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // heap_select<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Leaves the middle - first elements that come first in [first, last) in [first, middle),
+        // in no particular order. [first, middle) is kept as a heap whose top is the worst
+        // element so far; most later elements are rejected by one comparison. Gives up and
+        // returns false when too many elements get into the heap, as with reversed input.
+        template <typename RandomAccessIterator, typename Compare>
+        bool heap_select(RandomAccessIterator first,
+                         RandomAccessIterator middle,
+                         RandomAccessIterator last,
+                         Compare comp)
+        {
+            using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+            using std::swap;
+            Diff k{middle - first};
+            if (k >= 2)
+            {
+                make_heap(first, k, comp);
+            }
+            // Random input replaces the top about k * log(n / k) times.
+            Diff budget{2 * k + (last - middle) / 16};
+            for (RandomAccessIterator i{middle}; i != last; ++i)
+            {
+                if (comp(*i, *first))
+                {
+                    if (--budget < 0)
+                    {
+                        return false;
+                    }
+                    swap(*i, *first);
+                    down_heap(first, k, 0, comp);
+                }
+            }
+            return true;
+        }
+    } // namespace detail
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // nth_element<RandomAccessIterator>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename RandomAccessIterator>
+    void nth_element(RandomAccessIterator first, RandomAccessIterator nth, RandomAccessIterator last)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        omoteura::nth_element(first, nth, last, std::less<T>{});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // nth_element<RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Puts the element that a full sort would place at nth there, with no element after it
+    // ordered before it and none before it ordered after it. Linear time on average and in the
+    // worst case.
+    template <typename RandomAccessIterator, typename Compare>
+    void nth_element(RandomAccessIterator first,
+                     RandomAccessIterator nth,
+                     RandomAccessIterator last,
+                     Compare comp)
+    {
+        if (nth != last)
+        {
+            detail::introselect(first, nth, last, comp, detail::depth_limit(static_cast<double>(last - first)));
+        }
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // partial_sort<RandomAccessIterator>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename RandomAccessIterator>
+    void partial_sort(RandomAccessIterator first, RandomAccessIterator middle, RandomAccessIterator last)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        omoteura::partial_sort(first, middle, last, std::less<T>{});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // partial_sort<RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Sorts the middle - first elements that come first into [first, middle); the order of
+    // [middle, last) is unspecified.
+    template <typename RandomAccessIterator, typename Compare>
+    void partial_sort(RandomAccessIterator first,
+                      RandomAccessIterator middle,
+                      RandomAccessIterator last,
+                      Compare comp)
+    {
+        if (first == middle)
+        {
+            return;
+        }
+        bool selected{(middle - first) * detail::heap_select_ratio<RandomAccessIterator, Compare> <= last - first &&
+                      detail::heap_select(first, middle, last, comp)};
+        if (!selected && middle != last)
+        {
+            omoteura::nth_element(first, middle, last, comp);
+        }
+        intro_sort(first, middle, comp);
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // top_k<RandomAccessIterator>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Without a comparator the top elements are the largest ones.
+    template <typename RandomAccessIterator>
+    RandomAccessIterator top_k(RandomAccessIterator first,
+                               RandomAccessIterator last,
+                               typename std::iterator_traits<RandomAccessIterator>::difference_type k)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        return top_k(first, last, k, std::greater<T>{});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // top_k<RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Moves the k elements that come first under comp to the front in sorted order and returns
+    // the end of them. k larger than the range selects the whole range.
+    template <typename RandomAccessIterator, typename Compare>
+    RandomAccessIterator top_k(RandomAccessIterator first,
+                               RandomAccessIterator last,
+                               typename std::iterator_traits<RandomAccessIterator>::difference_type k,
+                               Compare comp)
+    {
+        RandomAccessIterator middle{first + std::max<decltype(k)>(0, std::min(k, last - first))};
+        omoteura::partial_sort(first, middle, last, comp);
+        return middle;
+    }
+} // namespace omoteura
@@ -0,0 +1,760 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// simd_partition.h
+// Copyright (c) 2025 ozk
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "sorting_network.h"
+
+namespace omoteura
+{
+    namespace detail
+    {
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // is_simd_partitionable<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <typename T>
+        struct is_partition_type
+            : std::integral_constant<bool,
+                                     (std::is_integral<T>::value && !std::is_same<T, bool>::value &&
+                                      (sizeof(T) == 4 || sizeof(T) == 8)) ||
+                                         std::is_same<T, float>::value || std::is_same<T, double>::value>
+        {
+        };
+
+        template <typename T, typename Compare>
+        struct is_partition_compare
+            : std::integral_constant<bool,
+                                     std::is_same<Compare, std::less<T>>::value ||
+                                         std::is_same<Compare, std::less<>>::value ||
+                                         std::is_same<Compare, std::greater<T>>::value ||
+                                         std::is_same<Compare, std::greater<>>::value>
+        {
+        };
+
+        // The kernels work on raw memory, so only pointers and std::vector iterators qualify.
+        template <typename RandomAccessIterator>
+        struct is_contiguous_iterator
+            : std::integral_constant<
+                  bool,
+                  std::is_pointer<RandomAccessIterator>::value ||
+                      std::is_same<RandomAccessIterator,
+                                   typename std::vector<typename std::iterator_traits<
+                                       RandomAccessIterator>::value_type>::iterator>::value>
+        {
+        };
+
+        template <typename RandomAccessIterator, typename Compare>
+        struct is_simd_partitionable
+            : std::conjunction<is_partition_type<typename std::iterator_traits<RandomAccessIterator>::value_type>,
+                               is_partition_compare<typename std::iterator_traits<RandomAccessIterator>::value_type,
+                                                    Compare>,
+                               is_contiguous_iterator<RandomAccessIterator>>
+        {
+        };
+
+        // Maps an element type to the lane type the kernels compare it as.
+        template <typename T>
+        using partition_lane_t = std::conditional_t<
+            std::is_floating_point<T>::value,
+            T,
+            std::conditional_t<sizeof(T) == 4,
+                               std::conditional_t<std::is_signed<T>::value, std::int32_t, std::uint32_t>,
+                               std::conditional_t<std::is_signed<T>::value, std::int64_t, std::uint64_t>>>;
+
+
+        // Vectors the kernels read per step. Holding this many vectors at each end lets the loads
+        // of one step go ahead without waiting for the stores of the previous vector.
+        constexpr int simd_partition_unroll = 4;
+
+        // Both kernels start by holding simd_partition_unroll vectors at each end, which is at
+        // most 128 elements for 64-byte vectors.
+        constexpr int simd_partition_min_size = 128;
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // partition_leftovers<Descending, T>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Places count buffered elements into the free slots [writeL, writeR), which must number
+        // exactly count. Every element is written to both ends and the side it does not belong to
+        // is overwritten later, so the loop does not branch. Elements equal to the pivot go to
+        // alternate sides.
+        template <bool Descending, typename T>
+        T *partition_leftovers(const T *rest, int count, T pivot, T *writeL, T *writeR)
+        {
+            bool alternate{false};
+            for (int k = 0; k < count; ++k)
+            {
+                T x{rest[k]};
+                bool equal{x == pivot};
+                bool left{(Descending ? pivot < x : x < pivot) || (equal && alternate)};
+                alternate = alternate != equal;
+                *writeL = x;
+                *(writeR - 1) = x;
+                writeL += left;
+                writeR -= !left;
+            }
+            return writeL;
+        }
+
+#if defined(OMOTEURA_INTROSORT_SIMD_X86)
+        // Each traits type provides, for one instruction set and one lane type:
+        //   broadcast(p)            the pivot in every lane
+        //   less / greater / equal  one bit per lane comparing v against the pivot
+        //   alternate               the odd lanes, which take elements equal to the pivot
+        //   store_partitioned(v, m, count, writeL, writeR)
+        //                           writes the count lanes set in m to [writeL, writeL + count)
+        //                           and the others to [writeR - (width - count), writeR); may
+        //                           also overwrite up to width slots at either end
+        //   store_partitioned_exact(v, m, count, writeL, writeR)
+        //                           the same, touching no other slot
+        // Loads and stores go through void pointers so that, say, long long can use the
+        // std::int64_t kernel without aliasing it.
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // compress_table<Lanes>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // For every mask of Lanes bits, the eight 32-bit lane indices that move the selected
+        // lanes to the front and the rest to the back, one index per byte.
+        template <int Lanes>
+        constexpr std::array<std::uint64_t, (1 << Lanes)> make_compress_table()
+        {
+            constexpr int scale{8 / Lanes};
+            std::array<std::uint64_t, (1 << Lanes)> table{};
+            for (int mask = 0; mask < (1 << Lanes); ++mask)
+            {
+                std::uint64_t entry{0};
+                int out{0};
+                for (int selected = 1; selected >= 0; --selected)
+                {
+                    for (int lane = 0; lane < Lanes; ++lane)
+                    {
+                        if (((mask >> lane) & 1) == selected)
+                        {
+                            for (int s = 0; s < scale; ++s)
+                            {
+                                entry |= static_cast<std::uint64_t>(lane * scale + s) << (8 * out);
+                                ++out;
+                            }
+                        }
+                    }
+                }
+                table[mask] = entry;
+            }
+            return table;
+        }
+
+        template <int Lanes>
+        inline constexpr std::array<std::uint64_t, (1 << Lanes)> compress_table{make_compress_table<Lanes>()};
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // AVX2 lane helpers
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <int Lanes>
+        OMOTEURA_INTROSORT_TARGET_AVX2 __m256i compress_index(unsigned m)
+        {
+            return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(compress_table<Lanes>.data() + m)));
+        }
+
+        // Masks for maskstore: 32-bit or 64-bit lanes below count, and lanes from count upwards.
+        OMOTEURA_INTROSORT_TARGET_AVX2 inline __m256i lanes_below_32(int count)
+        {
+            return _mm256_cmpgt_epi32(_mm256_set1_epi32(count), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        }
+        OMOTEURA_INTROSORT_TARGET_AVX2 inline __m256i lanes_from_32(int count)
+        {
+            return _mm256_cmpgt_epi32(_mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 8), _mm256_set1_epi32(count));
+        }
+        OMOTEURA_INTROSORT_TARGET_AVX2 inline __m256i lanes_below_64(int count)
+        {
+            return _mm256_cmpgt_epi64(_mm256_set1_epi64x(count), _mm256_setr_epi64x(0, 1, 2, 3));
+        }
+        OMOTEURA_INTROSORT_TARGET_AVX2 inline __m256i lanes_from_64(int count)
+        {
+            return _mm256_cmpgt_epi64(_mm256_setr_epi64x(1, 2, 3, 4), _mm256_set1_epi64x(count));
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // avx2_partition_traits<Lane>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <typename Lane>
+        struct avx2_partition_traits;
+
+        // Unsigned lanes are loaded with the sign bit flipped and compared as signed.
+        template <typename Lane>
+        struct avx2_partition_traits_32
+        {
+            using vector_type = __m256i;
+            static constexpr int width = 8;
+            static constexpr unsigned alternate = 0xAA;
+            static constexpr std::int32_t bias = std::is_signed<Lane>::value ? 0 : std::numeric_limits<std::int32_t>::min();
+
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type load(const void *p)
+            {
+                return _mm256_xor_si256(_mm256_loadu_si256(static_cast<const __m256i *>(p)), _mm256_set1_epi32(bias));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void store(void *p, vector_type v)
+            {
+                _mm256_storeu_si256(static_cast<__m256i *>(p), _mm256_xor_si256(v, _mm256_set1_epi32(bias)));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type broadcast(Lane p)
+            {
+                return _mm256_set1_epi32(static_cast<std::int32_t>(p) ^ bias);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static unsigned less(vector_type v, vector_type p)
+            {
+                return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(p, v))));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static unsigned greater(vector_type v, vector_type p)
+            {
+                return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, p))));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static unsigned equal(vector_type v, vector_type p)
+            {
+                return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, p))));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void store_partitioned(vector_type v, unsigned m, int, void *writeL, void *writeR)
+            {
+                vector_type packed{_mm256_permutevar8x32_epi32(v, compress_index<8>(m))};
+                store(writeL, packed);
+                store(static_cast<Lane *>(writeR) - width, packed);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void store_partitioned_exact(vector_type v, unsigned m, int count, void *writeL, void *writeR)
+            {
+                vector_type packed{_mm256_xor_si256(_mm256_permutevar8x32_epi32(v, compress_index<8>(m)), _mm256_set1_epi32(bias))};
+                _mm256_maskstore_epi32(static_cast<int *>(writeL), lanes_below_32(count), packed);
+                _mm256_maskstore_epi32(reinterpret_cast<int *>(static_cast<Lane *>(writeR) - width), lanes_from_32(count), packed);
+            }
+        };
+
+        template <typename Lane>
+        struct avx2_partition_traits_64
+        {
+            using vector_type = __m256i;
+            static constexpr int width = 4;
+            static constexpr unsigned alternate = 0xA;
+            static constexpr std::int64_t bias = std::is_signed<Lane>::value ? 0 : std::numeric_limits<std::int64_t>::min();
+
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type load(const void *p)
+            {
+                return _mm256_xor_si256(_mm256_loadu_si256(static_cast<const __m256i *>(p)), _mm256_set1_epi64x(bias));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void store(void *p, vector_type v)
+            {
+                _mm256_storeu_si256(static_cast<__m256i *>(p), _mm256_xor_si256(v, _mm256_set1_epi64x(bias)));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type broadcast(Lane p)
+            {
+                return _mm256_set1_epi64x(static_cast<std::int64_t>(p) ^ bias);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static unsigned less(vector_type v, vector_type p)
+            {
+                return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(p, v))));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static unsigned greater(vector_type v, vector_type p)
+            {
+                return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(v, p))));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static unsigned equal(vector_type v, vector_type p)
+            {
+                return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, p))));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void store_partitioned(vector_type v, unsigned m, int, void *writeL, void *writeR)
+            {
+                vector_type packed{_mm256_permutevar8x32_epi32(v, compress_index<4>(m))};
+                store(writeL, packed);
+                store(static_cast<Lane *>(writeR) - width, packed);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void store_partitioned_exact(vector_type v, unsigned m, int count, void *writeL, void *writeR)
+            {
+                vector_type packed{_mm256_xor_si256(_mm256_permutevar8x32_epi32(v, compress_index<4>(m)), _mm256_set1_epi64x(bias))};
+                _mm256_maskstore_epi64(static_cast<long long *>(writeL), lanes_below_64(count), packed);
+                _mm256_maskstore_epi64(reinterpret_cast<long long *>(static_cast<Lane *>(writeR) - width), lanes_from_64(count), packed);
+            }
+        };
+
+        template <>
+        struct avx2_partition_traits<std::int32_t> : avx2_partition_traits_32<std::int32_t>
+        {
+        };
+
+        template <>
+        struct avx2_partition_traits<std::uint32_t> : avx2_partition_traits_32<std::uint32_t>
+        {
+        };
+
+        template <>
+        struct avx2_partition_traits<std::int64_t> : avx2_partition_traits_64<std::int64_t>
+        {
+        };
+
+        template <>
+        struct avx2_partition_traits<std::uint64_t> : avx2_partition_traits_64<std::uint64_t>
+        {
+        };
+
+        template <>
+        struct avx2_partition_traits<float>
+        {
+            using vector_type = __m256;
+            static constexpr int width = 8;
+            static constexpr unsigned alternate = 0xAA;
+
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type load(const void *p)
+            {
+                return _mm256_loadu_ps(static_cast<const float *>(p));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void store(void *p, vector_type v)
+            {
+                _mm256_storeu_ps(static_cast<float *>(p), v);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type broadcast(float p)
+            {
+                return _mm256_set1_ps(p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static unsigned less(vector_type v, vector_type p)
+            {
+                return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(v, p, _CMP_LT_OQ)));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static unsigned greater(vector_type v, vector_type p)
+            {
+                return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(v, p, _CMP_GT_OQ)));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static unsigned equal(vector_type v, vector_type p)
+            {
+                return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(v, p, _CMP_EQ_OQ)));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void store_partitioned(vector_type v, unsigned m, int, void *writeL, void *writeR)
+            {
+                vector_type packed{_mm256_permutevar8x32_ps(v, compress_index<8>(m))};
+                store(writeL, packed);
+                store(static_cast<float *>(writeR) - width, packed);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void store_partitioned_exact(vector_type v, unsigned m, int count, void *writeL, void *writeR)
+            {
+                vector_type packed{_mm256_permutevar8x32_ps(v, compress_index<8>(m))};
+                _mm256_maskstore_ps(static_cast<float *>(writeL), lanes_below_32(count), packed);
+                _mm256_maskstore_ps(static_cast<float *>(writeR) - width, lanes_from_32(count), packed);
+            }
+        };
+
+        template <>
+        struct avx2_partition_traits<double>
+        {
+            using vector_type = __m256d;
+            static constexpr int width = 4;
+            static constexpr unsigned alternate = 0xA;
+
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type load(const void *p)
+            {
+                return _mm256_loadu_pd(static_cast<const double *>(p));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void store(void *p, vector_type v)
+            {
+                _mm256_storeu_pd(static_cast<double *>(p), v);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type broadcast(double p)
+            {
+                return _mm256_set1_pd(p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static unsigned less(vector_type v, vector_type p)
+            {
+                return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(v, p, _CMP_LT_OQ)));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static unsigned greater(vector_type v, vector_type p)
+            {
+                return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(v, p, _CMP_GT_OQ)));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static unsigned equal(vector_type v, vector_type p)
+            {
+                return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(v, p, _CMP_EQ_OQ)));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void store_partitioned(vector_type v, unsigned m, int, void *writeL, void *writeR)
+            {
+                vector_type packed{_mm256_castps_pd(_mm256_permutevar8x32_ps(_mm256_castpd_ps(v), compress_index<4>(m)))};
+                store(writeL, packed);
+                store(static_cast<double *>(writeR) - width, packed);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void store_partitioned_exact(vector_type v, unsigned m, int count, void *writeL, void *writeR)
+            {
+                vector_type packed{_mm256_castps_pd(_mm256_permutevar8x32_ps(_mm256_castpd_ps(v), compress_index<4>(m)))};
+                _mm256_maskstore_pd(static_cast<double *>(writeL), lanes_below_64(count), packed);
+                _mm256_maskstore_pd(static_cast<double *>(writeR) - width, lanes_from_64(count), packed);
+            }
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // avx512_partition_traits<Lane>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Both sides are compressed to the bottom of a register. The right side is always stored
+        // with a mask, which is as fast as a plain store and avoids the slow compress-to-memory
+        // form.
+        template <typename Lane>
+        struct avx512_partition_traits;
+
+        template <typename Lane>
+        struct avx512_partition_traits_32
+        {
+            using vector_type = __m512i;
+            static constexpr int width = 16;
+            static constexpr unsigned alternate = 0xAAAA;
+
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type load(const void *p)
+            {
+                return _mm512_loadu_si512(p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store(void *p, vector_type v)
+            {
+                _mm512_storeu_si512(p, v);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type broadcast(Lane p)
+            {
+                return _mm512_set1_epi32(static_cast<std::int32_t>(p));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static unsigned less(vector_type v, vector_type p)
+            {
+                return std::is_signed<Lane>::value ? _mm512_cmplt_epi32_mask(v, p) : _mm512_cmplt_epu32_mask(v, p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static unsigned greater(vector_type v, vector_type p)
+            {
+                return std::is_signed<Lane>::value ? _mm512_cmpgt_epi32_mask(v, p) : _mm512_cmpgt_epu32_mask(v, p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static unsigned equal(vector_type v, vector_type p)
+            {
+                return _mm512_cmpeq_epi32_mask(v, p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store_partitioned(vector_type v, unsigned m, int count, void *writeL, void *writeR)
+            {
+                store(writeL, _mm512_maskz_compress_epi32(static_cast<__mmask16>(m), v));
+                store_right(v, m, count, writeR);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store_partitioned_exact(vector_type v, unsigned m, int count, void *writeL, void *writeR)
+            {
+                _mm512_mask_storeu_epi32(writeL, static_cast<__mmask16>((1u << count) - 1), _mm512_maskz_compress_epi32(static_cast<__mmask16>(m), v));
+                store_right(v, m, count, writeR);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store_right(vector_type v, unsigned m, int count, void *writeR)
+            {
+                _mm512_mask_storeu_epi32(static_cast<Lane *>(writeR) - (width - count),
+                                         static_cast<__mmask16>((1u << (width - count)) - 1),
+                                         _mm512_maskz_compress_epi32(static_cast<__mmask16>(~m), v));
+            }
+        };
+
+        template <typename Lane>
+        struct avx512_partition_traits_64
+        {
+            using vector_type = __m512i;
+            static constexpr int width = 8;
+            static constexpr unsigned alternate = 0xAA;
+
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type load(const void *p)
+            {
+                return _mm512_loadu_si512(p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store(void *p, vector_type v)
+            {
+                _mm512_storeu_si512(p, v);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type broadcast(Lane p)
+            {
+                return _mm512_set1_epi64(static_cast<std::int64_t>(p));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static unsigned less(vector_type v, vector_type p)
+            {
+                return std::is_signed<Lane>::value ? _mm512_cmplt_epi64_mask(v, p) : _mm512_cmplt_epu64_mask(v, p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static unsigned greater(vector_type v, vector_type p)
+            {
+                return std::is_signed<Lane>::value ? _mm512_cmpgt_epi64_mask(v, p) : _mm512_cmpgt_epu64_mask(v, p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static unsigned equal(vector_type v, vector_type p)
+            {
+                return _mm512_cmpeq_epi64_mask(v, p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store_partitioned(vector_type v, unsigned m, int count, void *writeL, void *writeR)
+            {
+                store(writeL, _mm512_maskz_compress_epi64(static_cast<__mmask8>(m), v));
+                store_right(v, m, count, writeR);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store_partitioned_exact(vector_type v, unsigned m, int count, void *writeL, void *writeR)
+            {
+                _mm512_mask_storeu_epi64(writeL, static_cast<__mmask8>((1u << count) - 1), _mm512_maskz_compress_epi64(static_cast<__mmask8>(m), v));
+                store_right(v, m, count, writeR);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store_right(vector_type v, unsigned m, int count, void *writeR)
+            {
+                _mm512_mask_storeu_epi64(static_cast<Lane *>(writeR) - (width - count),
+                                         static_cast<__mmask8>((1u << (width - count)) - 1),
+                                         _mm512_maskz_compress_epi64(static_cast<__mmask8>(~m), v));
+            }
+        };
+
+        template <>
+        struct avx512_partition_traits<std::int32_t> : avx512_partition_traits_32<std::int32_t>
+        {
+        };
+
+        template <>
+        struct avx512_partition_traits<std::uint32_t> : avx512_partition_traits_32<std::uint32_t>
+        {
+        };
+
+        template <>
+        struct avx512_partition_traits<std::int64_t> : avx512_partition_traits_64<std::int64_t>
+        {
+        };
+
+        template <>
+        struct avx512_partition_traits<std::uint64_t> : avx512_partition_traits_64<std::uint64_t>
+        {
+        };
+
+        template <>
+        struct avx512_partition_traits<float>
+        {
+            using vector_type = __m512;
+            static constexpr int width = 16;
+            static constexpr unsigned alternate = 0xAAAA;
+
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type load(const void *p)
+            {
+                return _mm512_loadu_ps(p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store(void *p, vector_type v)
+            {
+                _mm512_storeu_ps(p, v);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type broadcast(float p)
+            {
+                return _mm512_set1_ps(p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static unsigned less(vector_type v, vector_type p)
+            {
+                return _mm512_cmp_ps_mask(v, p, _CMP_LT_OQ);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static unsigned greater(vector_type v, vector_type p)
+            {
+                return _mm512_cmp_ps_mask(v, p, _CMP_GT_OQ);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static unsigned equal(vector_type v, vector_type p)
+            {
+                return _mm512_cmp_ps_mask(v, p, _CMP_EQ_OQ);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store_partitioned(vector_type v, unsigned m, int count, void *writeL, void *writeR)
+            {
+                store(writeL, _mm512_maskz_compress_ps(static_cast<__mmask16>(m), v));
+                store_right(v, m, count, writeR);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store_partitioned_exact(vector_type v, unsigned m, int count, void *writeL, void *writeR)
+            {
+                _mm512_mask_storeu_ps(writeL, static_cast<__mmask16>((1u << count) - 1), _mm512_maskz_compress_ps(static_cast<__mmask16>(m), v));
+                store_right(v, m, count, writeR);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store_right(vector_type v, unsigned m, int count, void *writeR)
+            {
+                _mm512_mask_storeu_ps(static_cast<float *>(writeR) - (width - count),
+                                      static_cast<__mmask16>((1u << (width - count)) - 1),
+                                      _mm512_maskz_compress_ps(static_cast<__mmask16>(~m), v));
+            }
+        };
+
+        template <>
+        struct avx512_partition_traits<double>
+        {
+            using vector_type = __m512d;
+            static constexpr int width = 8;
+            static constexpr unsigned alternate = 0xAA;
+
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type load(const void *p)
+            {
+                return _mm512_loadu_pd(p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store(void *p, vector_type v)
+            {
+                _mm512_storeu_pd(p, v);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type broadcast(double p)
+            {
+                return _mm512_set1_pd(p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static unsigned less(vector_type v, vector_type p)
+            {
+                return _mm512_cmp_pd_mask(v, p, _CMP_LT_OQ);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static unsigned greater(vector_type v, vector_type p)
+            {
+                return _mm512_cmp_pd_mask(v, p, _CMP_GT_OQ);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static unsigned equal(vector_type v, vector_type p)
+            {
+                return _mm512_cmp_pd_mask(v, p, _CMP_EQ_OQ);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store_partitioned(vector_type v, unsigned m, int count, void *writeL, void *writeR)
+            {
+                store(writeL, _mm512_maskz_compress_pd(static_cast<__mmask8>(m), v));
+                store_right(v, m, count, writeR);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store_partitioned_exact(vector_type v, unsigned m, int count, void *writeL, void *writeR)
+            {
+                _mm512_mask_storeu_pd(writeL, static_cast<__mmask8>((1u << count) - 1), _mm512_maskz_compress_pd(static_cast<__mmask8>(m), v));
+                store_right(v, m, count, writeR);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store_right(vector_type v, unsigned m, int count, void *writeR)
+            {
+                _mm512_mask_storeu_pd(static_cast<double *>(writeR) - (width - count),
+                                      static_cast<__mmask8>((1u << (width - count)) - 1),
+                                      _mm512_maskz_compress_pd(static_cast<__mmask8>(~m), v));
+            }
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // popcount_lanes
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        OMOTEURA_INTROSORT_TARGET_SSE42 inline int popcount_lanes(unsigned m)
+        {
+            return _mm_popcnt_u32(m);
+        }
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+// The vectors never cross a call: the body below is always inlined into a kernel compiled for
+// their instruction set.
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // partition_vector<Traits, Descending, T>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // In-place vector partition of [first, last). The first and last simd_partition_unroll
+        // vectors are held in registers, which frees that many slots at each end. Each step reads
+        // from the side with fewer free slots, so both sides keep room for a full vector store
+        // and nothing unread is overwritten.
+        template <typename Traits, bool Descending, typename T>
+        OMOTEURA_INTROSORT_ALWAYS_INLINE T *partition_vector(T *first, T *last, T pivot)
+        {
+            using Vector = typename Traits::vector_type;
+            constexpr int width{Traits::width};
+            constexpr int step{simd_partition_unroll * width};
+            Vector pivotV{Traits::broadcast(pivot)};
+            Vector held[2 * simd_partition_unroll];
+            for (int k = 0; k < simd_partition_unroll; ++k)
+            {
+                held[k] = Traits::load(first + k * width);
+                held[simd_partition_unroll + k] = Traits::load(last - (k + 1) * width);
+            }
+            T *readL{first + step};
+            T *readR{last - step};
+            T *writeL{first};
+            T *writeR{last};
+            while (readR - readL >= step)
+            {
+                bool fromLeft{readL - writeL <= writeR - readR};
+                T *source{fromLeft ? readL : readR - step};
+                readL += fromLeft ? step : 0;
+                readR -= fromLeft ? 0 : step;
+                // Load the whole step first: with fewer than step free slots, the first stores
+                // reach into the block being read.
+                Vector block[simd_partition_unroll];
+                for (int k = 0; k < simd_partition_unroll; ++k)
+                {
+                    block[k] = Traits::load(source + k * width);
+                }
+                for (int k = 0; k < simd_partition_unroll; ++k)
+                {
+                    Vector v{block[k]};
+                    unsigned m{(Descending ? Traits::greater(v, pivotV) : Traits::less(v, pivotV)) |
+                               (Traits::equal(v, pivotV) & Traits::alternate)};
+                    int count{popcount_lanes(m)};
+                    Traits::store_partitioned(v, m, count, writeL, writeR);
+                    writeL += count;
+                    writeR -= width - count;
+                }
+            }
+            // Buffer the unread elements; then every slot in [writeL, writeR) is free and the
+            // held vectors can be written exactly.
+            T rest[step];
+            int restSize{static_cast<int>(readR - readL)};
+            for (int k = 0; k < restSize; ++k)
+            {
+                rest[k] = readL[k];
+            }
+            int fullSize{restSize - restSize % width};
+            for (int k = 0; k < 2 * simd_partition_unroll + fullSize / width; ++k)
+            {
+                Vector v{k < 2 * simd_partition_unroll ? held[k] : Traits::load(rest + (k - 2 * simd_partition_unroll) * width)};
+                unsigned m{(Descending ? Traits::greater(v, pivotV) : Traits::less(v, pivotV)) |
+                           (Traits::equal(v, pivotV) & Traits::alternate)};
+                int count{popcount_lanes(m)};
+                Traits::store_partitioned_exact(v, m, count, writeL, writeR);
+                writeL += count;
+                writeR -= width - count;
+            }
+            return partition_leftovers<Descending>(rest + fullSize, restSize - fullSize, pivot, writeL, writeR);
+        }
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // partition_avx512<Traits, Descending, T> / partition_avx2<Traits, Descending, T>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <typename Traits, bool Descending, typename T>
+        OMOTEURA_INTROSORT_TARGET_AVX512 T *partition_avx512(T *first, T *last, T pivot)
+        {
+            return partition_vector<Traits, Descending>(first, last, pivot);
+        }
+
+        template <typename Traits, bool Descending, typename T>
+        OMOTEURA_INTROSORT_TARGET_AVX2 T *partition_avx2(T *first, T *last, T pivot)
+        {
+            return partition_vector<Traits, Descending>(first, last, pivot);
+        }
+#endif
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // simd_partition<Descending, T>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Moves the elements of [first, last) that belong before pivot to the front and returns
+        // the start of the rest; elements equal to pivot are split between both sides. Uses the
+        // kernel for level, which must not exceed current_simd_level(), and returns nullptr below
+        // AVX2. The range must hold at least simd_partition_min_size elements.
+        template <bool Descending, typename T>
+        T *simd_partition(T *first, T *last, T pivot, simd_level level)
+        {
+#if defined(OMOTEURA_INTROSORT_SIMD_X86)
+            using Lane = partition_lane_t<T>;
+            if (level == simd_level::avx512)
+            {
+                return partition_avx512<avx512_partition_traits<Lane>, Descending>(first, last, pivot);
+            }
+            if (level == simd_level::avx2)
+            {
+                return partition_avx2<avx2_partition_traits<Lane>, Descending>(first, last, pivot);
+            }
+#endif
+            static_cast<void>(first);
+            static_cast<void>(last);
+            static_cast<void>(pivot);
+            static_cast<void>(level);
+            return nullptr;
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // simd_partition<Descending, T>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Same with the best kernel the CPU runs.
+        template <bool Descending, typename T>
+        T *simd_partition(T *first, T *last, T pivot)
+        {
+            return simd_partition<Descending>(first, last, pivot, current_simd_level());
+        }
+    } // namespace detail
+} // namespace omoteura
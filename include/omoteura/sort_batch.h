@@ -0,0 +1,305 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// sort_batch.h
+// Copyright (c) 2025 ozk
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "intro_sort.h"
+
+namespace omoteura
+{
+    template <typename RandomAccessIterator, typename OffsetIterator, typename Compare>
+    void sort_batch(RandomAccessIterator first, OffsetIterator offsetsFirst, OffsetIterator offsetsLast, Compare comp);
+    template <typename RandomAccessIterator, typename OffsetIterator, typename Compare>
+    void sort_batch(RandomAccessIterator first,
+                    OffsetIterator offsetsFirst,
+                    OffsetIterator offsetsLast,
+                    Compare comp,
+                    unsigned threads);
+
+    namespace detail
+    {
+        // Segments this short that fixed_network_sort does not take go to insertion_sort, which
+        // beats setting up a SIMD network for them.
+        constexpr int tiny_segment_size = 8;
+
+        // Longest segment of arithmetic keys that a wide network or merge_segment sorts; longer
+        // ones go to intro_sort, whose setup is cheap next to the work.
+        constexpr int merged_segment_max_size = wide_network_max_size;
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // merge_halves<InputIterator, OutputIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Merges sorted [first, first + middle) and [first + middle, first + n), whose lengths
+        // differ by at most one, into out. The smallest elements are taken from the front and
+        // the largest from the back in the same loop, so two independent chains of loads and
+        // comparisons run at once. The comparisons only pick which input advances, so random
+        // keys cost no mispredicted branches, and ties go to the left run from both ends.
+        template <typename InputIterator, typename OutputIterator, typename Compare>
+        void merge_halves(InputIterator first,
+                          std::ptrdiff_t middle,
+                          std::ptrdiff_t n,
+                          OutputIterator out,
+                          Compare comp)
+        {
+            assert(std::abs(2 * middle - n) <= 1);
+            std::ptrdiff_t steps{std::min(middle, n - middle)};
+            std::ptrdiff_t left{0};
+            std::ptrdiff_t right{middle};
+            std::ptrdiff_t leftEnd{middle};
+            std::ptrdiff_t rightEnd{n};
+            for (std::ptrdiff_t k = 0; k < steps; ++k)
+            {
+                bool takeRight{comp(first[right], first[left])};
+                out[k] = takeRight ? first[right] : first[left];
+                right += takeRight;
+                left += !takeRight;
+                bool takeLeft{comp(first[rightEnd - 1], first[leftEnd - 1])};
+                out[n - 1 - k] = takeLeft ? first[leftEnd - 1] : first[rightEnd - 1];
+                leftEnd -= takeLeft;
+                rightEnd -= !takeLeft;
+            }
+            // With odd n, the element in the middle of the output is the only one left.
+            if (n % 2 != 0)
+            {
+                out[steps] = left < leftEnd ? first[left] : first[right];
+            }
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // merge_segment<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Sorts up to merged_segment_max_size arithmetic keys that no wide network takes:
+        // small_sort finishes a power of two of blocks no longer than a leaf, and merge passes
+        // go back and forth between the segment and a buffer on the stack. The block boundaries
+        // i * n / blocks keep the two runs of every merge within one element of each other.
+        // Unlike intro_sort, there is no partition and no depth limit to compute.
+        template <typename RandomAccessIterator, typename Compare>
+        void merge_segment(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+        {
+            using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            constexpr std::ptrdiff_t blockSize = leaf_threshold<RandomAccessIterator, Compare>;
+            std::ptrdiff_t n{last - first};
+            assert(n <= merged_segment_max_size);
+            std::ptrdiff_t blocks{1};
+            while (blocks * blockSize < n)
+            {
+                blocks *= 2;
+            }
+            for (std::ptrdiff_t b = 0; b < blocks; ++b)
+            {
+                small_sort(first + b * n / blocks, first + (b + 1) * n / blocks, comp);
+            }
+            T buffer[merged_segment_max_size];
+            bool inBuffer{false};
+            for (std::ptrdiff_t runs = blocks / 2; runs >= 1; runs /= 2)
+            {
+                for (std::ptrdiff_t r = 0; r < runs; ++r)
+                {
+                    std::ptrdiff_t begin{r * n / runs};
+                    std::ptrdiff_t end{(r + 1) * n / runs};
+                    std::ptrdiff_t middle{(2 * r + 1) * n / (2 * runs) - begin};
+                    if (inBuffer)
+                    {
+                        merge_halves(buffer + begin, middle, end - begin, first + begin, comp);
+                    }
+                    else
+                    {
+                        merge_halves(first + begin, middle, end - begin, buffer + begin, comp);
+                    }
+                }
+                inBuffer = !inBuffer;
+            }
+            if (inBuffer)
+            {
+                std::copy(buffer, buffer + n, first);
+            }
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // sort_segment<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Picks a kernel by size: a fixed network for short segments of integers, insertion_sort
+        // for tiny ones, small_sort up to the leaf threshold, a wide SIMD network or else
+        // merge_segment for arithmetic keys up to merged_segment_max_size, and intro_sort above
+        // that. Segments longer than a leaf
+        // that are already sorted cost one pass. Unlike a call to intro_sort, nothing is spent on
+        // setup for the short ones.
+        template <typename RandomAccessIterator, typename Compare>
+        void sort_segment(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+        {
+            using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            auto n{last - first};
+            // Compilers keep branches in the floating-point exchanges, since a conditional move
+            // has to preserve the order of NaN and signed zeros; those go to the SIMD network.
+            if constexpr (std::is_integral<T>::value && is_branchless_compare<T, Compare>::value)
+            {
+                if (n <= fixed_network_max_size)
+                {
+                    fixed_network_sort(first, static_cast<int>(n), comp);
+                    return;
+                }
+            }
+            if (n <= tiny_segment_size)
+            {
+                insertion_sort(first, last, comp);
+            }
+            else if (n <= leaf_threshold<RandomAccessIterator, Compare>)
+            {
+                small_sort(first, last, comp);
+            }
+            else
+            {
+                if constexpr (is_branchless_compare<T, Compare>::value)
+                {
+                    if (n <= merged_segment_max_size)
+                    {
+                        // Like intro_sort, finishes a segment that is one ascending or strictly
+                        // descending run in one pass; on random keys the scan stops at once.
+                        if (!sort_presorted<leaf_threshold<RandomAccessIterator, Compare>>(first, last, comp, nullptr, n) &&
+                            !network_sort<wide_network_max_size>(first, last, comp))
+                        {
+                            merge_segment(first, last, comp);
+                        }
+                        return;
+                    }
+                }
+                intro_sort(first, last, comp);
+            }
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // sort_segments<RandomAccessIterator, OffsetIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Sorts segments [begin, end) of the batch.
+        template <typename RandomAccessIterator, typename OffsetIterator, typename Compare>
+        void sort_segments(RandomAccessIterator first,
+                           OffsetIterator offsets,
+                           std::ptrdiff_t begin,
+                           std::ptrdiff_t end,
+                           Compare comp)
+        {
+            for (std::ptrdiff_t s = begin; s < end; ++s)
+            {
+                sort_segment(first + offsets[s], first + offsets[s + 1], comp);
+            }
+        }
+    } // namespace detail
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // sort_batch<RandomAccessIterator, OffsetIterator>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename RandomAccessIterator, typename OffsetIterator>
+    void sort_batch(RandomAccessIterator first, OffsetIterator offsetsFirst, OffsetIterator offsetsLast)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        sort_batch(first, offsetsFirst, offsetsLast, std::less<T>{});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // sort_batch<RandomAccessIterator, OffsetIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Sorts each segment of one buffer on its own. The k + 1 offsets in [offsetsFirst,
+    // offsetsLast) are nondecreasing and delimit k segments: segment s is
+    // [first + offsets[s], first + offsets[s + 1]).
+    template <typename RandomAccessIterator, typename OffsetIterator, typename Compare>
+    void sort_batch(RandomAccessIterator first, OffsetIterator offsetsFirst, OffsetIterator offsetsLast, Compare comp)
+    {
+        std::ptrdiff_t segments{static_cast<std::ptrdiff_t>(offsetsLast - offsetsFirst) - 1};
+        detail::sort_segments(first, offsetsFirst, 0, segments, comp);
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // sort_batch<RandomAccessIterator, OffsetIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Spreads the segments over threads, the calling thread included; 0 or 1 sorts on the calling
+    // thread only. Workers take runs of consecutive segments of about grainSize elements at a
+    // time, so small batches stay on the calling thread.
+    template <typename RandomAccessIterator, typename OffsetIterator, typename Compare>
+    void sort_batch(RandomAccessIterator first,
+                    OffsetIterator offsetsFirst,
+                    OffsetIterator offsetsLast,
+                    Compare comp,
+                    unsigned threads)
+    {
+        constexpr std::ptrdiff_t grainSize = 1 << 14;
+        std::ptrdiff_t segments{static_cast<std::ptrdiff_t>(offsetsLast - offsetsFirst) - 1};
+        if (segments <= 0)
+        {
+            return;
+        }
+        std::ptrdiff_t total{static_cast<std::ptrdiff_t>(offsetsFirst[segments] - offsetsFirst[0])};
+        if (threads <= 1 || total <= grainSize)
+        {
+            detail::sort_segments(first, offsetsFirst, 0, segments, comp);
+            return;
+        }
+
+        std::ptrdiff_t grain{std::max<std::ptrdiff_t>(1, segments * grainSize / total)};
+        std::ptrdiff_t grains{(segments + grain - 1) / grain};
+        std::atomic<std::ptrdiff_t> next{0};
+        std::atomic<bool> failed{false};
+        std::mutex errorMutex;
+        std::exception_ptr error;
+        auto work = [&] {
+            try
+            {
+                for (std::ptrdiff_t begin{next.fetch_add(grain)}; begin < segments && !failed.load();
+                     begin = next.fetch_add(grain))
+                {
+                    detail::sort_segments(first, offsetsFirst, begin, std::min(segments, begin + grain), comp);
+                }
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock{errorMutex};
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+                failed.store(true);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        unsigned extra{static_cast<unsigned>(std::min<std::ptrdiff_t>(threads, grains)) - 1};
+        workers.reserve(extra);
+        for (unsigned i = 0; i < extra; ++i)
+        {
+            try
+            {
+                workers.emplace_back(work);
+            }
+            catch (const std::system_error &)
+            {
+                // Keep going with the workers we already have.
+                break;
+            }
+        }
+        work();
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+} // namespace omoteura
@@ -0,0 +1,206 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// sort_stats.h
+// Copyright (c) 2025 ozk
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace omoteura
+{
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // sort_stats
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Counters filled in by the overloads of insertion_sort, heap_sort, quick_sort and intro_sort
+    // that take a statistics argument. They add to what is already there, so one instance can
+    // collect several sorts.
+    struct sort_stats
+    {
+        static constexpr int imbalance_buckets = 8;
+
+        std::uint64_t comparisons{0};
+        std::uint64_t swaps{0};
+        // Moves outside of swaps, including moves into and out of temporaries.
+        std::uint64_t moves{0};
+        // Depth of the deepest partitioning call; 1 when the first partition is the only one.
+        int max_depth{0};
+        // Times intro_sort ran out of depth and finished a range with heap_sort.
+        std::uint64_t heap_fallbacks{0};
+        // Partitions by the share of the smaller side: bucket b counts shares in
+        // [b / 16, (b + 1) / 16), and the last bucket also takes the perfectly balanced ones.
+        std::uint64_t partition_imbalance[imbalance_buckets]{};
+        // Time spent finishing small ranges, which includes the counting overhead itself.
+        std::chrono::nanoseconds leaf_sort_time{0};
+    };
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // no_stats
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Statistics policy that collects nothing; passing it calls the uninstrumented algorithm.
+    struct no_stats
+    {
+    };
+
+    namespace detail
+    {
+        template <typename Statistics>
+        struct is_stats_policy
+            : std::integral_constant<bool,
+                                     std::is_same<Statistics, sort_stats>::value ||
+                                         std::is_same<Statistics, no_stats>::value>
+        {
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // counting_compare<Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Wraps the user's comparator and carries the statistics through every helper that
+        // already takes a comparator.
+        template <typename Compare>
+        class counting_compare
+        {
+        public:
+            counting_compare(Compare comp, sort_stats &stats)
+                : comp_(comp), stats_(&stats)
+            {
+            }
+
+            template <typename L, typename R>
+            bool operator()(L &&a, R &&b)
+            {
+                ++stats_->comparisons;
+                return comp_(std::forward<L>(a), std::forward<R>(b));
+            }
+
+            template <typename L, typename R>
+            bool operator()(L &&a, R &&b) const
+            {
+                ++stats_->comparisons;
+                return comp_(std::forward<L>(a), std::forward<R>(b));
+            }
+
+            sort_stats &stats() const
+            {
+                return *stats_;
+            }
+
+        private:
+            Compare comp_;
+            sort_stats *stats_;
+        };
+
+        template <typename Compare>
+        struct is_counting_compare : std::false_type
+        {
+        };
+
+        template <typename Compare>
+        struct is_counting_compare<counting_compare<Compare>> : std::true_type
+        {
+        };
+
+        // The hooks below compile to nothing unless the comparator is a counting_compare.
+
+        template <typename Compare>
+        void count_swaps(const Compare &, std::ptrdiff_t)
+        {
+        }
+
+        template <typename Compare>
+        void count_swaps(const counting_compare<Compare> &comp, std::ptrdiff_t count)
+        {
+            comp.stats().swaps += static_cast<std::uint64_t>(count);
+        }
+
+        template <typename Compare>
+        void count_moves(const Compare &, std::ptrdiff_t)
+        {
+        }
+
+        template <typename Compare>
+        void count_moves(const counting_compare<Compare> &comp, std::ptrdiff_t count)
+        {
+            comp.stats().moves += static_cast<std::uint64_t>(count);
+        }
+
+        template <typename Compare>
+        void count_heap_fallback(const Compare &)
+        {
+        }
+
+        template <typename Compare>
+        void count_heap_fallback(const counting_compare<Compare> &comp)
+        {
+            ++comp.stats().heap_fallbacks;
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // count_partition<Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Records a partition with depth partitions above it that split a range into sides of
+        // leftSize and rightSize elements.
+        template <typename Compare>
+        void count_partition(const Compare &, int, std::ptrdiff_t, std::ptrdiff_t)
+        {
+        }
+
+        template <typename Compare>
+        void count_partition(const counting_compare<Compare> &comp,
+                             int depth,
+                             std::ptrdiff_t leftSize,
+                             std::ptrdiff_t rightSize)
+        {
+            constexpr int buckets = sort_stats::imbalance_buckets;
+            sort_stats &stats{comp.stats()};
+            stats.max_depth = std::max(stats.max_depth, depth + 1);
+            std::ptrdiff_t total{leftSize + rightSize};
+            if (total > 0)
+            {
+                std::ptrdiff_t bucket{2 * buckets * std::min(leftSize, rightSize) / total};
+                ++stats.partition_imbalance[std::min<std::ptrdiff_t>(bucket, buckets - 1)];
+            }
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // leaf_timer<Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Adds the lifetime of the object to sort_stats::leaf_sort_time.
+        template <typename Compare>
+        class leaf_timer
+        {
+        public:
+            explicit leaf_timer(const Compare &)
+            {
+            }
+        };
+
+        template <typename Compare>
+        class leaf_timer<counting_compare<Compare>>
+        {
+        public:
+            explicit leaf_timer(const counting_compare<Compare> &comp)
+                : stats_(&comp.stats()), start_(std::chrono::steady_clock::now())
+            {
+            }
+
+            leaf_timer(const leaf_timer &) = delete;
+            leaf_timer &operator=(const leaf_timer &) = delete;
+
+            ~leaf_timer()
+            {
+                stats_->leaf_sort_time += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start_);
+            }
+
+        private:
+            sort_stats *stats_;
+            std::chrono::steady_clock::time_point start_;
+        };
+    } // namespace detail
+} // namespace omoteura
@@ -0,0 +1,432 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// sort_stream.h
+// Copyright (c) 2025 ozk
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "intro_sort.h"
+#include "parallel_merge_sort.h"
+
+namespace omoteura
+{
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // sort_stream_options
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    struct sort_stream_options
+    {
+        // Elements per chunk; 0 picks about 1 MiB of elements, so that each chunk is sorted
+        // within the L2 cache of one core.
+        std::size_t chunk_size{0};
+        // Background threads that sort full chunks; 0 sorts each chunk on the thread that
+        // fills it. One keeps up unless input arrives faster than a core can sort it.
+        unsigned threads{1};
+    };
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // sort_stream<T, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Sorts elements that arrive over time. Pushed elements are cut into chunks, and each full
+    // chunk is sorted with intro_sort on a background thread while input is still arriving.
+    // finish() sorts what is left and sets up a loser tree over the sorted chunks, so the
+    // merged output is produced one element at a time as it is read, through begin()/end() or
+    // drain(). After the last push only the last chunk is sorted before the first element is
+    // out, instead of the whole input. The sort is not stable. push is called from one thread
+    // at a time; an exception thrown by comp on any thread is rethrown by finish().
+    template <typename T, typename Compare = std::less<T>>
+    class sort_stream
+    {
+    public:
+        class iterator;
+
+        explicit sort_stream(Compare comp = Compare{}, const sort_stream_options &options = {})
+            : comp_(comp),
+              chunkSize_(options.chunk_size != 0 ? options.chunk_size
+                                                 : std::max<std::size_t>(detail::merge_chunk_bytes / sizeof(T), 1)),
+              threads_(options.threads)
+        {
+            filling_.reserve(chunkSize_);
+        }
+
+        explicit sort_stream(const sort_stream_options &options)
+            : sort_stream(Compare{}, options)
+        {
+        }
+
+        sort_stream(const sort_stream &) = delete;
+        sort_stream &operator=(const sort_stream &) = delete;
+
+        // Chunks no thread has started on are dropped.
+        ~sort_stream()
+        {
+            stop_workers();
+        }
+
+        void push(const T &item)
+        {
+            check_open();
+            filling_.push_back(item);
+            if (filling_.size() == chunkSize_)
+            {
+                submit_chunk();
+            }
+        }
+
+        void push(T &&item)
+        {
+            check_open();
+            filling_.push_back(std::move(item));
+            if (filling_.size() == chunkSize_)
+            {
+                submit_chunk();
+            }
+        }
+
+        // Pushes a batch.
+        template <typename InputIterator>
+        void push(InputIterator first, InputIterator last)
+        {
+            for (; first != last; ++first)
+            {
+                push(*first);
+            }
+        }
+
+        // Ends the input and waits for the chunks being sorted, sorting the ones nobody has
+        // started on this thread. Afterwards the merged output can be read. Does nothing if the
+        // stream has already finished.
+        void finish()
+        {
+            if (finished_)
+            {
+                return;
+            }
+            finished_ = true;
+            std::unique_lock<std::mutex> lock{mutex_};
+            if (!filling_.empty())
+            {
+                chunks_.push_back(std::move(filling_));
+            }
+            while (started_ < chunks_.size())
+            {
+                std::vector<T> &chunk{chunks_[started_++]};
+                lock.unlock();
+                sort_chunk(chunk);
+                lock.lock();
+                ++sortedCount_;
+            }
+            sorted_.wait(lock, [this] { return sortedCount_ == chunks_.size(); });
+            lock.unlock();
+            stop_workers();
+            if (error_)
+            {
+                chunks_.clear();
+                std::rethrow_exception(error_);
+            }
+            for (std::vector<T> &chunk : chunks_)
+            {
+                if (!chunk.empty())
+                {
+                    runs_.push_back(detail::sorted_run<T>{chunk.data(), chunk.data() + chunk.size()});
+                }
+            }
+            build_tree();
+        }
+
+        // Finishes the stream if needed. Reading through the iterator moves past each element,
+        // which may be moved from.
+        iterator begin()
+        {
+            finish();
+            return iterator{this};
+        }
+
+        iterator end()
+        {
+            return iterator{};
+        }
+
+        // Finishes the stream if needed and calls callback(std::move(element)) for every
+        // remaining element in order.
+        template <typename Callback>
+        void drain(Callback callback)
+        {
+            finish();
+            while (!done())
+            {
+                callback(std::move(top()));
+                pop();
+            }
+        }
+
+    private:
+        void check_open() const
+        {
+            if (finished_)
+            {
+                throw std::logic_error("sort_stream: push after finish");
+            }
+        }
+
+        // Hands the full chunk to a worker, starting the workers on the first one, or sorts it
+        // here when there are none.
+        void submit_chunk()
+        {
+            std::vector<T> chunk;
+            chunk.reserve(chunkSize_);
+            chunk.swap(filling_);
+            if (!workersStarted_)
+            {
+                workersStarted_ = true;
+                start_workers();
+            }
+            if (workers_.empty())
+            {
+                sort_chunk(chunk);
+                std::lock_guard<std::mutex> lock{mutex_};
+                chunks_.push_back(std::move(chunk));
+                ++started_;
+                ++sortedCount_;
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock{mutex_};
+                chunks_.push_back(std::move(chunk));
+            }
+            ready_.notify_one();
+        }
+
+        void start_workers()
+        {
+            workers_.reserve(threads_);
+            for (unsigned i = 0; i < threads_; ++i)
+            {
+                try
+                {
+                    workers_.emplace_back([this] { work(); });
+                }
+                catch (const std::system_error &)
+                {
+                    // Keep going with the workers we already have.
+                    break;
+                }
+            }
+        }
+
+        void stop_workers()
+        {
+            {
+                std::lock_guard<std::mutex> lock{mutex_};
+                stopping_ = true;
+            }
+            ready_.notify_all();
+            for (std::thread &worker : workers_)
+            {
+                worker.join();
+            }
+            workers_.clear();
+        }
+
+        void work()
+        {
+            std::unique_lock<std::mutex> lock{mutex_};
+            while (true)
+            {
+                ready_.wait(lock, [this] { return stopping_ || started_ < chunks_.size(); });
+                if (stopping_)
+                {
+                    return;
+                }
+                // chunks_ is a deque, so the chunk stays put while more are pushed.
+                std::vector<T> &chunk{chunks_[started_++]};
+                lock.unlock();
+                sort_chunk(chunk);
+                lock.lock();
+                ++sortedCount_;
+                sorted_.notify_all();
+            }
+        }
+
+        // Keeps the first exception for finish() to rethrow.
+        void sort_chunk(std::vector<T> &chunk)
+        {
+            try
+            {
+                intro_sort(chunk.begin(), chunk.end(), comp_);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock{mutex_};
+                if (!error_)
+                {
+                    error_ = std::current_exception();
+                }
+            }
+        }
+
+        // Compares the elements the players of the loser tree point at.
+        auto less()
+        {
+            return [this](T *a, T *b) { return comp_(*a, *b); };
+        }
+
+        // Plays the matches of the loser tree over runs_, every one of which is non-empty.
+        void build_tree()
+        {
+            std::vector<T *> heads;
+            heads.reserve(runs_.size());
+            for (const detail::sorted_run<T> &r : runs_)
+            {
+                heads.push_back(r.first);
+            }
+            tree_.build(std::move(heads), less());
+        }
+
+        bool done() const
+        {
+            return tree_.size() == 0;
+        }
+
+        T &top() const
+        {
+            return *tree_.winner();
+        }
+
+        // Moves past the smallest element. When its run runs out, the tree is rebuilt without
+        // it, so matches never need end checks.
+        void pop()
+        {
+            T *&head{tree_.winner()};
+            if (++head != runs_[tree_.winner_leaf()].last)
+            {
+                tree_.replay(less());
+                return;
+            }
+            int exhausted{tree_.winner_leaf()};
+            tree_.for_each([this](T *h, int leaf) { runs_[leaf].first = h; });
+            runs_.erase(runs_.begin() + exhausted);
+            build_tree();
+        }
+
+        Compare comp_;
+        std::size_t chunkSize_;
+        unsigned threads_;
+        bool finished_{false};
+        std::vector<T> filling_;
+
+        std::mutex mutex_;
+        // Signalled when a chunk is waiting to be sorted or the workers should stop.
+        std::condition_variable ready_;
+        // Signalled when a worker has sorted a chunk.
+        std::condition_variable sorted_;
+        std::deque<std::vector<T>> chunks_;
+        // Chunks before started_ have been taken by a thread; sortedCount_ of them are done.
+        std::size_t started_{0};
+        std::size_t sortedCount_{0};
+        bool stopping_{false};
+        std::exception_ptr error_;
+        bool workersStarted_{false};
+        std::vector<std::thread> workers_;
+
+        std::vector<detail::sorted_run<T>> runs_;
+        detail::loser_tree<T *> tree_;
+    };
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // sort_stream<T, Compare>::iterator
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Single-pass iterator over the merged output; incrementing consumes the current element.
+    template <typename T, typename Compare>
+    class sort_stream<T, Compare>::iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using reference = T &;
+        using pointer = T *;
+
+        // What it++ returns: the element it consumed.
+        class postfix_value
+        {
+        public:
+            explicit postfix_value(T &&value)
+                : value_(std::move(value))
+            {
+            }
+
+            T &operator*()
+            {
+                return value_;
+            }
+
+        private:
+            T value_;
+        };
+
+        iterator() = default;
+
+        reference operator*() const
+        {
+            return stream_->top();
+        }
+
+        pointer operator->() const
+        {
+            return &stream_->top();
+        }
+
+        iterator &operator++()
+        {
+            stream_->pop();
+            return *this;
+        }
+
+        // Takes the element out before consuming it, so that *it++ still reads it.
+        postfix_value operator++(int)
+        {
+            postfix_value result{std::move(stream_->top())};
+            stream_->pop();
+            return result;
+        }
+
+        friend bool operator==(const iterator &a, const iterator &b)
+        {
+            return a.at_end() == b.at_end();
+        }
+
+        friend bool operator!=(const iterator &a, const iterator &b)
+        {
+            return a.at_end() != b.at_end();
+        }
+
+    private:
+        friend class sort_stream;
+
+        explicit iterator(sort_stream *stream)
+            : stream_(stream)
+        {
+        }
+
+        bool at_end() const
+        {
+            return stream_ == nullptr || stream_->done();
+        }
+
+        sort_stream *stream_{nullptr};
+    };
+} // namespace omoteura
@@ -0,0 +1,266 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// sort_unique.h
+// Copyright (c) 2025 ozk
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "intro_sort.h"
+
+namespace omoteura
+{
+    template <typename RandomAccessIterator, typename Compare>
+    RandomAccessIterator sort_unique(RandomAccessIterator first, RandomAccessIterator last, Compare comp);
+    template <typename RandomAccessIterator, typename Projection, typename ReduceOperation, typename Compare>
+    RandomAccessIterator sort_reduce_by_key(RandomAccessIterator first,
+                                            RandomAccessIterator last,
+                                            Projection proj,
+                                            ReduceOperation reduce,
+                                            Compare comp);
+
+    namespace detail
+    {
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // keep_first
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Collapses equal elements by dropping all but the first.
+        struct keep_first
+        {
+            template <typename T, typename U>
+            void operator()(T &, U &&) const
+            {
+            }
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // key_compare<Projection, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Compares elements by their projected keys.
+        template <typename Projection, typename Compare>
+        class key_compare
+        {
+        public:
+            key_compare(Projection proj, Compare comp)
+                : proj_(proj), comp_(comp)
+            {
+            }
+
+            template <typename L, typename R>
+            bool operator()(const L &a, const R &b)
+            {
+                return comp_(std::invoke(proj_, a), std::invoke(proj_, b));
+            }
+
+        private:
+            Projection proj_;
+            Compare comp_;
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // sort_collapse<Threshold, RandomAccessIterator, Compare, Collapse>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // intro_sort that visits its partitions from left to right and moves every finished
+        // range down to out as soon as it is sorted, while it is still in cache. An element equal
+        // to the last one written is handed to collapse(*(out - 1), std::move(element)) instead of
+        // being written, and the elements equal to a repeated pivot are never sorted at all, so
+        // duplicates drop out one partition early and the range is read only once more.
+        template <int Threshold, typename RandomAccessIterator, typename Compare, typename Collapse>
+        class sort_collapse
+        {
+        public:
+            using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+
+            sort_collapse(RandomAccessIterator first, Compare comp, Collapse collapse, int depthLimit)
+                : comp_(comp), collapse_(collapse), depthLimit_(depthLimit), base_(first), out_(first)
+            {
+            }
+
+            RandomAccessIterator operator()(RandomAccessIterator first, RandomAccessIterator last)
+            {
+                sort(first, last, 0);
+                return out_;
+            }
+
+        private:
+            // Finishes the left side of every partition first, which needs a recursion instead of
+            // the explicit stack of intro_sort_impl. Each call is one partition deeper, so the depth
+            // of the recursion is bounded by depthLimit.
+            void sort(RandomAccessIterator first, RandomAccessIterator last, int depth)
+            {
+                while (true)
+                {
+                    Diff n{last - first};
+                    if (n <= Threshold)
+                    {
+                        {
+                            leaf_timer<Compare> timer{comp_};
+                            small_sort(first, last, comp_);
+                        }
+                        append(first, last);
+                        return;
+                    }
+                    if (depth >= depthLimit_)
+                    {
+                        count_heap_fallback(comp_);
+                        heap_sort<fallback_heap>(first, last, comp_);
+                        append(first, last);
+                        return;
+                    }
+                    if (select_pivot(first, last, comp_))
+                    {
+                        std::pair<RandomAccessIterator, RandomAccessIterator> equal{partition_three_way(first, last, comp_)};
+                        count_partition(comp_, depth, equal.first - first, last - equal.second);
+                        ++depth;
+                        sort(first, equal.first, depth);
+                        append_equal(equal.first, equal.second);
+                        first = equal.second;
+                        continue;
+                    }
+                    std::pair<RandomAccessIterator, bool> result{partition_range(first, last, comp_)};
+                    RandomAccessIterator i{result.first};
+                    Diff leftSize{i - first};
+                    Diff rightSize{last - (i + 1)};
+                    count_partition(comp_, depth, leftSize, rightSize);
+                    bool unbalanced{leftSize < n / 8 || rightSize < n / 8};
+                    if (unbalanced)
+                    {
+                        break_patterns(first, i, comp_);
+                        break_patterns(i + 1, last, comp_);
+                    }
+                    if (!unbalanced && result.second && partial_insertion_sort(first, i, comp_) &&
+                        partial_insertion_sort(i + 1, last, comp_))
+                    {
+                        append(first, last);
+                        return;
+                    }
+                    ++depth;
+                    sort(first, i, depth);
+                    append(i, i + 1);
+                    first = i + 1;
+                }
+            }
+
+            // Moves the sorted range [first, last), which lies at or after out_ and holds no
+            // element less than those before out_, down to out_.
+            void append(RandomAccessIterator first, RandomAccessIterator last)
+            {
+                for (; first != last; ++first)
+                {
+                    if (out_ != base_ && !comp_(*(out_ - 1), *first))
+                    {
+                        collapse_(*(out_ - 1), std::move(*first));
+                    }
+                    else
+                    {
+                        if (out_ != first)
+                        {
+                            *out_ = std::move(*first);
+                            count_moves(comp_, 1);
+                        }
+                        ++out_;
+                    }
+                }
+            }
+
+            // Same for a range of elements that are all equal, which only needs one comparison.
+            void append_equal(RandomAccessIterator first, RandomAccessIterator last)
+            {
+                if (out_ == base_ || comp_(*(out_ - 1), *first))
+                {
+                    if (out_ != first)
+                    {
+                        *out_ = std::move(*first);
+                        count_moves(comp_, 1);
+                    }
+                    ++out_;
+                    ++first;
+                }
+                for (; first != last; ++first)
+                {
+                    collapse_(*(out_ - 1), std::move(*first));
+                }
+            }
+
+            Compare comp_;
+            Collapse collapse_;
+            int depthLimit_;
+            RandomAccessIterator base_;
+            RandomAccessIterator out_;
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // sort_collapse_entry<RandomAccessIterator, Compare, Collapse>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <typename RandomAccessIterator, typename Compare, typename Collapse>
+        RandomAccessIterator sort_collapse_entry(RandomAccessIterator first,
+                                                 RandomAccessIterator last,
+                                                 Compare comp,
+                                                 Collapse collapse)
+        {
+            constexpr int threshold = leaf_threshold<RandomAccessIterator, Compare>;
+            sort_collapse<threshold, RandomAccessIterator, Compare, Collapse> impl{
+                first, comp, collapse, depth_limit(static_cast<double>(last - first))};
+            return impl(first, last);
+        }
+    } // namespace detail
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // sort_unique<RandomAccessIterator>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename RandomAccessIterator>
+    RandomAccessIterator sort_unique(RandomAccessIterator first, RandomAccessIterator last)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        return sort_unique(first, last, std::less<T>{});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // sort_unique<RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Sorts [first, last) and removes equal elements in the same pass, like intro_sort followed
+    // by std::unique. Returns the new end; [first, end) is sorted with one element of every
+    // group of equal ones, and the elements after it are left in a valid but unspecified state.
+    // Which element of a group is kept is unspecified.
+    template <typename RandomAccessIterator, typename Compare>
+    RandomAccessIterator sort_unique(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+    {
+        return detail::sort_collapse_entry(first, last, comp, detail::keep_first{});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // sort_reduce_by_key<RandomAccessIterator, Projection, ReduceOperation>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename RandomAccessIterator, typename Projection, typename ReduceOperation>
+    RandomAccessIterator sort_reduce_by_key(RandomAccessIterator first,
+                                            RandomAccessIterator last,
+                                            Projection proj,
+                                            ReduceOperation reduce)
+    {
+        using Reference = typename std::iterator_traits<RandomAccessIterator>::reference;
+        using Key = std::decay_t<std::invoke_result_t<Projection &, Reference>>;
+        return sort_reduce_by_key(first, last, proj, reduce, std::less<Key>{});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // sort_reduce_by_key<RandomAccessIterator, Projection, ReduceOperation, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Sorts [first, last) by the keys proj returns and folds the elements with equal keys into
+    // one, the group-by of a query. reduce(kept, std::move(other)) adds other to kept and must
+    // leave the key of kept as it is. Returns the new end; [first, end) holds one element per
+    // key in order. comp compares keys, not elements. The order in which the elements of a
+    // group are folded is unspecified, so reduce should be associative and commutative.
+    template <typename RandomAccessIterator, typename Projection, typename ReduceOperation, typename Compare>
+    RandomAccessIterator sort_reduce_by_key(RandomAccessIterator first,
+                                            RandomAccessIterator last,
+                                            Projection proj,
+                                            ReduceOperation reduce,
+                                            Compare comp)
+    {
+        return detail::sort_collapse_entry(first, last, detail::key_compare<Projection, Compare>{proj, comp}, reduce);
+    }
+} // namespace omoteura
@@ -0,0 +1,209 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// sort_workspace.h
+// Copyright (c) 2025 ozk
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace omoteura
+{
+    namespace detail
+    {
+        template <typename T>
+        class workspace_array;
+    } // namespace detail
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // sort_workspace
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Scratch memory for the sorts that need buffers, reused across calls. Buffers are carved
+    // from one block and handed back in reverse order. A call that needs more than the block
+    // holds gets extra blocks; once nothing is in use they are replaced by one block as large as
+    // the most that was in use at once, so repeated sorts of the same size stop allocating after
+    // the first. The block only ever grows. Not thread-safe: use one workspace per thread.
+    class sort_workspace
+    {
+    public:
+        sort_workspace() = default;
+
+        explicit sort_workspace(std::size_t bytes)
+        {
+            reserve_bytes(bytes);
+        }
+
+        sort_workspace(const sort_workspace &) = delete;
+        sort_workspace &operator=(const sort_workspace &) = delete;
+
+        // Makes room for count elements of T at once.
+        template <typename T>
+        void reserve(std::size_t count)
+        {
+            reserve_bytes(count * sizeof(T) + alignof(T));
+        }
+
+        // Grows the block to at least bytes. Does nothing while buffers are in use.
+        void reserve_bytes(std::size_t bytes)
+        {
+            if (live_ == 0 && bytes > capacity_)
+            {
+                block_.reset();
+                capacity_ = 0;
+                block_.reset(new unsigned char[bytes]);
+                capacity_ = bytes;
+            }
+        }
+
+        // Size of the block in bytes.
+        std::size_t capacity() const
+        {
+            return capacity_;
+        }
+
+    private:
+        template <typename T>
+        friend class detail::workspace_array;
+
+        void *allocate(std::size_t bytes, std::size_t alignment)
+        {
+            std::size_t offset{(used_ + alignment - 1) / alignment * alignment};
+            if (offset + bytes <= capacity_)
+            {
+                used_ = offset + bytes;
+                ++live_;
+                peak_ = std::max(peak_, used_ + overflowBytes_);
+                return block_.get() + offset;
+            }
+            if (live_ == 0)
+            {
+                reserve_bytes(bytes);
+                used_ = bytes;
+                ++live_;
+                peak_ = std::max(peak_, used_);
+                return block_.get();
+            }
+            overflow_.emplace_back(new unsigned char[bytes]);
+            overflowBytes_ += bytes + alignment;
+            ++live_;
+            peak_ = std::max(peak_, used_ + overflowBytes_);
+            return overflow_.back().get();
+        }
+
+        // used is the offset to return to, as it was before the matching allocate.
+        void release(std::size_t used)
+        {
+            assert(live_ > 0);
+            used_ = used;
+            if (--live_ == 0)
+            {
+                if (!overflow_.empty())
+                {
+                    overflow_.clear();
+                    overflowBytes_ = 0;
+                    try
+                    {
+                        reserve_bytes(peak_);
+                    }
+                    catch (const std::bad_alloc &)
+                    {
+                        // Keep the block we have; the next call allocates again.
+                    }
+                }
+                used_ = 0;
+                peak_ = 0;
+            }
+        }
+
+        std::unique_ptr<unsigned char[]> block_;
+        std::size_t capacity_{0};
+        std::size_t used_{0};
+        std::size_t peak_{0};
+        int live_{0};
+        std::vector<std::unique_ptr<unsigned char[]>> overflow_;
+        std::size_t overflowBytes_{0};
+    };
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // thread_local_workspace
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // A workspace owned by the calling thread and freed when the thread exits.
+    inline sort_workspace &thread_local_workspace()
+    {
+        thread_local sort_workspace workspace;
+        return workspace;
+    }
+
+    namespace detail
+    {
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // workspace_array<T>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Room for up to capacity elements of T taken from a sort_workspace, filled from the
+        // front and destroyed with the array.
+        template <typename T>
+        class workspace_array
+        {
+        public:
+            static_assert(alignof(T) <= alignof(std::max_align_t), "sort_workspace does not support over-aligned types");
+
+            workspace_array(sort_workspace &workspace, std::size_t capacity)
+                : workspace_(workspace), used_(workspace.used_), capacity_(capacity)
+            {
+                data_ = static_cast<T *>(workspace.allocate(capacity * sizeof(T), alignof(T)));
+            }
+
+            workspace_array(const workspace_array &) = delete;
+            workspace_array &operator=(const workspace_array &) = delete;
+
+            ~workspace_array()
+            {
+                std::destroy_n(data_, size_);
+                workspace_.release(used_);
+            }
+
+            template <typename... Args>
+            void emplace_back(Args &&...args)
+            {
+                assert(size_ < capacity_);
+                ::new (static_cast<void *>(data_ + size_)) T(std::forward<Args>(args)...);
+                ++size_;
+            }
+
+            // Default-initializes the rest of the room, so trivial types are left as they are.
+            void fill()
+            {
+                std::uninitialized_default_construct_n(data_ + size_, capacity_ - size_);
+                size_ = capacity_;
+            }
+
+            T *begin() const
+            {
+                return data_;
+            }
+
+            T *end() const
+            {
+                return data_ + size_;
+            }
+
+            std::size_t size() const
+            {
+                return size_;
+            }
+
+        private:
+            sort_workspace &workspace_;
+            std::size_t used_;
+            T *data_{nullptr};
+            std::size_t size_{0};
+            std::size_t capacity_;
+        };
+    } // namespace detail
+} // namespace omoteura
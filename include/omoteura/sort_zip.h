@@ -0,0 +1,356 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// sort_zip.h
+// Copyright (c) 2025 ozk
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "intro_sort.h"
+
+namespace omoteura
+{
+    template <typename RandomAccessIterator, typename Compare>
+    std::vector<std::size_t> argsort(RandomAccessIterator first, RandomAccessIterator last, Compare comp);
+
+    namespace detail
+    {
+        template <typename... Values>
+        class zip_reference;
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // zip_value<Values...>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // One element of every column, held by value while the sort has it out of the range.
+        template <typename... Values>
+        class zip_value
+        {
+        public:
+            // Copies, even from std::move(*it): the sort also writes T pivot{*it}, and a proxy
+            // cannot tell the two apart.
+            explicit zip_value(const zip_reference<Values...> &reference)
+                : values_(reference.references_)
+            {
+            }
+
+            const auto &key() const
+            {
+                return std::get<0>(values_);
+            }
+
+        private:
+            friend class zip_reference<Values...>;
+
+            std::tuple<Values...> values_;
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // zip_reference<Values...>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Refers to the elements at one position of every column. Assigning through it writes
+        // all of them, and swap exchanges all of them.
+        template <typename... Values>
+        class zip_reference
+        {
+        public:
+            explicit zip_reference(Values &...references)
+                : references_(references...)
+            {
+            }
+
+            zip_reference(const zip_reference &) = default;
+
+            zip_reference &operator=(const zip_reference &other)
+            {
+                assign(other.references_, std::index_sequence_for<Values...>{});
+                return *this;
+            }
+
+            zip_reference &operator=(const zip_value<Values...> &value)
+            {
+                assign(value.values_, std::index_sequence_for<Values...>{});
+                return *this;
+            }
+
+            zip_reference &operator=(zip_value<Values...> &&value)
+            {
+                assign(std::move(value.values_), std::index_sequence_for<Values...>{});
+                return *this;
+            }
+
+            friend void swap(zip_reference a, zip_reference b)
+            {
+                a.swap_with(b, std::index_sequence_for<Values...>{});
+            }
+
+            const auto &key() const
+            {
+                return std::get<0>(references_);
+            }
+
+        private:
+            friend class zip_value<Values...>;
+
+            template <typename Tuple, std::size_t... I>
+            void assign(Tuple &&source, std::index_sequence<I...>)
+            {
+                ((std::get<I>(references_) = std::get<I>(std::forward<Tuple>(source))), ...);
+            }
+
+            template <std::size_t... I>
+            void swap_with(zip_reference &other, std::index_sequence<I...>)
+            {
+                using std::swap;
+                (swap(std::get<I>(references_), std::get<I>(other.references_)), ...);
+            }
+
+            std::tuple<Values &...> references_;
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // zip_iterator<Iterators...>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Walks the columns in lockstep. Only the offset moves, so stepping costs the same however
+        // many columns there are.
+        template <typename... Iterators>
+        class zip_iterator
+        {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = zip_value<typename std::iterator_traits<Iterators>::value_type...>;
+            using difference_type = std::ptrdiff_t;
+            using reference = zip_reference<typename std::iterator_traits<Iterators>::value_type...>;
+            using pointer = void;
+
+            static_assert(std::conjunction<std::is_same<typename std::iterator_traits<Iterators>::reference,
+                                                        typename std::iterator_traits<Iterators>::value_type &>...>::value,
+                          "sort_zip requires iterators to mutable elements");
+
+            zip_iterator() = default;
+
+            zip_iterator(Iterators... firsts, difference_type offset)
+                : firsts_(firsts...), offset_(offset)
+            {
+            }
+
+            reference operator*() const
+            {
+                return dereference(offset_, std::index_sequence_for<Iterators...>{});
+            }
+
+            reference operator[](difference_type k) const
+            {
+                return dereference(offset_ + k, std::index_sequence_for<Iterators...>{});
+            }
+
+            zip_iterator &operator++()
+            {
+                ++offset_;
+                return *this;
+            }
+
+            zip_iterator operator++(int)
+            {
+                zip_iterator old{*this};
+                ++offset_;
+                return old;
+            }
+
+            zip_iterator &operator--()
+            {
+                --offset_;
+                return *this;
+            }
+
+            zip_iterator operator--(int)
+            {
+                zip_iterator old{*this};
+                --offset_;
+                return old;
+            }
+
+            zip_iterator &operator+=(difference_type k)
+            {
+                offset_ += k;
+                return *this;
+            }
+
+            zip_iterator &operator-=(difference_type k)
+            {
+                offset_ -= k;
+                return *this;
+            }
+
+            friend zip_iterator operator+(zip_iterator it, difference_type k)
+            {
+                return it += k;
+            }
+
+            friend zip_iterator operator+(difference_type k, zip_iterator it)
+            {
+                return it += k;
+            }
+
+            friend zip_iterator operator-(zip_iterator it, difference_type k)
+            {
+                return it -= k;
+            }
+
+            friend difference_type operator-(const zip_iterator &a, const zip_iterator &b)
+            {
+                return a.offset_ - b.offset_;
+            }
+
+            friend bool operator==(const zip_iterator &a, const zip_iterator &b)
+            {
+                return a.offset_ == b.offset_;
+            }
+
+            friend bool operator!=(const zip_iterator &a, const zip_iterator &b)
+            {
+                return a.offset_ != b.offset_;
+            }
+
+            friend bool operator<(const zip_iterator &a, const zip_iterator &b)
+            {
+                return a.offset_ < b.offset_;
+            }
+
+            friend bool operator>(const zip_iterator &a, const zip_iterator &b)
+            {
+                return a.offset_ > b.offset_;
+            }
+
+            friend bool operator<=(const zip_iterator &a, const zip_iterator &b)
+            {
+                return a.offset_ <= b.offset_;
+            }
+
+            friend bool operator>=(const zip_iterator &a, const zip_iterator &b)
+            {
+                return a.offset_ >= b.offset_;
+            }
+
+        private:
+            template <std::size_t... I>
+            reference dereference(difference_type k, std::index_sequence<I...>) const
+            {
+                return reference{std::get<I>(firsts_)[k]...};
+            }
+
+            std::tuple<Iterators...> firsts_;
+            difference_type offset_{0};
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // zip_compare<Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Compares zip elements by their keys.
+        template <typename Compare>
+        class zip_compare
+        {
+        public:
+            explicit zip_compare(Compare comp)
+                : comp_(comp)
+            {
+            }
+
+            template <typename L, typename R>
+            bool operator()(const L &a, const R &b)
+            {
+                return comp_(a.key(), b.key());
+            }
+
+            template <typename L, typename R>
+            bool operator()(const L &a, const R &b) const
+            {
+                return comp_(a.key(), b.key());
+            }
+
+        private:
+            Compare comp_;
+        };
+    } // namespace detail
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // sort_zip<Compare, KeyIterator, PayloadIterators...>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Sorts [keysFirst, keysLast) by comp and moves the elements at the same positions of every
+    // payload column along with their keys, for data kept as separate arrays. Runs intro_sort's
+    // comparison path on the columns in place; payload elements are copied where a single
+    // element would be moved, so the columns should be cheap to copy.
+    template <typename Compare,
+              typename KeyIterator,
+              typename... PayloadIterators,
+              typename = std::enable_if_t<
+                  std::is_invocable_r<bool,
+                                      Compare &,
+                                      const typename std::iterator_traits<KeyIterator>::value_type &,
+                                      const typename std::iterator_traits<KeyIterator>::value_type &>::value>>
+    void sort_zip(Compare comp, KeyIterator keysFirst, KeyIterator keysLast, PayloadIterators... payloadFirsts)
+    {
+        using Zip = detail::zip_iterator<KeyIterator, PayloadIterators...>;
+        typename Zip::difference_type n{keysLast - keysFirst};
+        if (n < 2)
+        {
+            return;
+        }
+        Zip first{keysFirst, payloadFirsts..., 0};
+        intro_sort(first, first + n, detail::zip_compare<Compare>{comp});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // sort_zip<KeyIterator, PayloadIterators...>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename KeyIterator, typename... PayloadIterators>
+    void sort_zip(KeyIterator keysFirst, KeyIterator keysLast, PayloadIterators... payloadFirsts)
+    {
+        using Key = typename std::iterator_traits<KeyIterator>::value_type;
+        sort_zip(std::less<Key>{}, keysFirst, keysLast, payloadFirsts...);
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // argsort<RandomAccessIterator>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename RandomAccessIterator>
+    std::vector<std::size_t> argsort(RandomAccessIterator first, RandomAccessIterator last)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        return argsort(first, last, std::less<T>{});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // argsort<RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Returns the positions of [first, last) in sorted order, so first[order[0]], first[order[1]],
+    // ... is sorted, and leaves the range as it is. Sorts (element, index) entries like
+    // intro_sort_by_key, so integral and floating-point elements take the radix sort.
+    template <typename RandomAccessIterator, typename Compare>
+    std::vector<std::size_t> argsort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        using Entry = std::pair<T, std::size_t>;
+        std::size_t n{static_cast<std::size_t>(last - first)};
+        std::vector<Entry> entries;
+        entries.reserve(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            entries.emplace_back(first[i], i);
+        }
+        detail::sort_key_entries(entries.begin(), entries.end(), comp);
+        std::vector<std::size_t> order;
+        order.reserve(n);
+        for (const Entry &entry : entries)
+        {
+            order.push_back(entry.second);
+        }
+        return order;
+    }
+} // namespace omoteura
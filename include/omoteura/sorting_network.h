@@ -0,0 +1,1024 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// sorting_network.h
+// Copyright (c) 2025 ozk
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+// Define OMOTEURA_INTROSORT_DISABLE_SIMD to always use insertion_sort for small ranges.
+#if !defined(OMOTEURA_INTROSORT_DISABLE_SIMD) && \
+    (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || (defined(_M_IX86) && !defined(_M_ARM)))
+#define OMOTEURA_INTROSORT_SIMD_X86 1
+#endif
+
+#if defined(OMOTEURA_INTROSORT_SIMD_X86)
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define OMOTEURA_INTROSORT_TARGET_AVX512
+#define OMOTEURA_INTROSORT_TARGET_AVX2
+#define OMOTEURA_INTROSORT_TARGET_SSE42
+#define OMOTEURA_INTROSORT_ALWAYS_INLINE __forceinline
+#define OMOTEURA_INTROSORT_UNROLL
+#else
+#define OMOTEURA_INTROSORT_TARGET_AVX512 __attribute__((target("avx512f")))
+#define OMOTEURA_INTROSORT_TARGET_AVX2 __attribute__((target("avx2")))
+#define OMOTEURA_INTROSORT_TARGET_SSE42 __attribute__((target("sse4.2")))
+// Kernel bodies shared by several instruction sets carry no target of their own and are
+// always inlined into a function that has one, so the traits calls inline as well.
+#define OMOTEURA_INTROSORT_ALWAYS_INLINE inline __attribute__((always_inline))
+// Unrolls the network loops completely, so the registers stay in registers and the blend
+// masks become constants.
+#define OMOTEURA_INTROSORT_UNROLL _Pragma("GCC unroll 32")
+#endif
+#endif
+
+namespace omoteura
+{
+    namespace detail
+    {
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // simd_level
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        enum class simd_level
+        {
+            none,
+            sse42,
+            avx2,
+            avx512,
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // detect_simd_level
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        inline simd_level detect_simd_level()
+        {
+#if !defined(OMOTEURA_INTROSORT_SIMD_X86)
+            return simd_level::none;
+#elif defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid(info, 0);
+            int maxLeaf{info[0]};
+            __cpuid(info, 1);
+            bool sse42{(info[2] & (1 << 20)) != 0};
+            bool osxsave{(info[2] & (1 << 27)) != 0};
+            bool avx{(info[2] & (1 << 28)) != 0};
+            bool avx2{false};
+            bool avx512{false};
+            unsigned long long xcr0{osxsave ? _xgetbv(0) : 0};
+            if (maxLeaf >= 7 && avx && (xcr0 & 0x6) == 0x6)
+            {
+                __cpuidex(info, 7, 0);
+                avx2 = (info[1] & (1 << 5)) != 0;
+                // AVX-512 also needs the OS to save the opmask and upper ZMM registers.
+                avx512 = avx2 && (info[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6;
+            }
+            return avx512 ? simd_level::avx512
+                   : avx2 ? simd_level::avx2
+                   : sse42 ? simd_level::sse42
+                           : simd_level::none;
+#else
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2"))
+            {
+                return simd_level::avx512;
+            }
+            if (__builtin_cpu_supports("avx2"))
+            {
+                return simd_level::avx2;
+            }
+            if (__builtin_cpu_supports("sse4.2"))
+            {
+                return simd_level::sse42;
+            }
+            return simd_level::none;
+#endif
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // current_simd_level
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        inline simd_level current_simd_level()
+        {
+            static const simd_level level{detect_simd_level()};
+            return level;
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // is_network_sortable<T, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <typename T>
+        struct is_network_type
+            : std::integral_constant<bool,
+                                     std::is_same<T, std::int32_t>::value || std::is_same<T, std::int64_t>::value ||
+                                         std::is_same<T, std::uint32_t>::value ||
+                                         std::is_same<T, std::uint64_t>::value || std::is_same<T, float>::value ||
+                                         std::is_same<T, double>::value>
+        {
+        };
+
+        template <typename T, typename Compare>
+        struct is_network_sortable : std::false_type
+        {
+        };
+
+        template <typename T>
+        struct is_network_sortable<T, std::less<T>> : is_network_type<T>
+        {
+        };
+
+        template <typename T>
+        struct is_network_sortable<T, std::less<>> : is_network_type<T>
+        {
+        };
+
+        template <typename T>
+        struct is_network_sortable<T, std::greater<T>> : is_network_type<T>
+        {
+        };
+
+        template <typename T>
+        struct is_network_sortable<T, std::greater<>> : is_network_type<T>
+        {
+        };
+
+        // Longest range network_sort accepts by default, and the leaf size of intro_sort.
+        constexpr int network_max_size = 64;
+
+        // Longest range network_sort<wide_network_max_size> accepts. The 128- and 256-lane
+        // networks beat sorting halves and merging them with AVX-512, and for 32-bit elements
+        // with AVX2, despite the registers spilling to the stack.
+        constexpr int wide_network_max_size = 256;
+
+#if defined(OMOTEURA_INTROSORT_SIMD_X86)
+        constexpr bool network_sort_compiled = true;
+#else
+        constexpr bool network_sort_compiled = false;
+#endif
+
+#if defined(OMOTEURA_INTROSORT_SIMD_X86)
+        // Each traits type provides, for one instruction set and one element type:
+        //   vertical(a, b, lo, hi)   lane-wise lo = min(a, b), hi = max(a, b)
+        //   horizontal(v, p, lo, hi) like vertical for a lane and its partner p; equal or
+        //                            unordered lanes keep their own value so no bits are lost
+        //   permute(v, j)            swaps lane i with lane i ^ j
+        //   take_upper(base, j, k)   lanes (base + i) that keep the upper value of their pair
+        //   blend(a, b, m)           b where m is set, otherwise a
+        // Floating-point exchanges compare and blend instead of using min/max, so -0.0 and NaN
+        // are moved, never duplicated.
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // avx2_traits<T>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <typename T>
+        struct avx2_traits;
+
+        template <>
+        struct avx2_traits<std::int32_t>
+        {
+            using value_type = std::int32_t;
+            using vector_type = __m256i;
+            static constexpr int width = 8;
+
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type load(const value_type *p)
+            {
+                return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void store(value_type *p, vector_type v)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void vertical(vector_type a, vector_type b, vector_type &lo, vector_type &hi)
+            {
+                lo = _mm256_min_epi32(a, b);
+                hi = _mm256_max_epi32(a, b);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void horizontal(vector_type v, vector_type p, vector_type &lo, vector_type &hi)
+            {
+                vertical(v, p, lo, hi);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type permute(vector_type v, int j)
+            {
+                return j == 4 ? _mm256_permute2x128_si256(v, v, 0x01)
+                       : j == 2 ? _mm256_shuffle_epi32(v, 0x4E)
+                                : _mm256_shuffle_epi32(v, 0xB1);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static __m256i take_upper(int base, int j, int k)
+            {
+                __m256i index{_mm256_add_epi32(_mm256_set1_epi32(base), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7))};
+                __m256i inUpper{_mm256_cmpeq_epi32(_mm256_and_si256(index, _mm256_set1_epi32(j)), _mm256_set1_epi32(j))};
+                __m256i inDescending{_mm256_cmpeq_epi32(_mm256_and_si256(index, _mm256_set1_epi32(k)), _mm256_set1_epi32(k))};
+                return _mm256_xor_si256(inUpper, inDescending);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type blend(vector_type a, vector_type b, __m256i m)
+            {
+                return _mm256_blendv_epi8(a, b, m);
+            }
+        };
+
+        template <>
+        struct avx2_traits<std::int64_t>
+        {
+            using value_type = std::int64_t;
+            using vector_type = __m256i;
+            static constexpr int width = 4;
+
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type load(const value_type *p)
+            {
+                return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void store(value_type *p, vector_type v)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void vertical(vector_type a, vector_type b, vector_type &lo, vector_type &hi)
+            {
+                __m256i swapped{_mm256_cmpgt_epi64(a, b)};
+                lo = _mm256_blendv_epi8(a, b, swapped);
+                hi = _mm256_blendv_epi8(b, a, swapped);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void horizontal(vector_type v, vector_type p, vector_type &lo, vector_type &hi)
+            {
+                vertical(v, p, lo, hi);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type permute(vector_type v, int j)
+            {
+                return j == 2 ? _mm256_permute2x128_si256(v, v, 0x01) : _mm256_shuffle_epi32(v, 0x4E);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static __m256i take_upper(int base, int j, int k)
+            {
+                __m256i index{_mm256_add_epi64(_mm256_set1_epi64x(base), _mm256_setr_epi64x(0, 1, 2, 3))};
+                __m256i inUpper{_mm256_cmpeq_epi64(_mm256_and_si256(index, _mm256_set1_epi64x(j)), _mm256_set1_epi64x(j))};
+                __m256i inDescending{_mm256_cmpeq_epi64(_mm256_and_si256(index, _mm256_set1_epi64x(k)), _mm256_set1_epi64x(k))};
+                return _mm256_xor_si256(inUpper, inDescending);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type blend(vector_type a, vector_type b, __m256i m)
+            {
+                return _mm256_blendv_epi8(a, b, m);
+            }
+        };
+
+        template <>
+        struct avx2_traits<float>
+        {
+            using value_type = float;
+            using vector_type = __m256;
+            static constexpr int width = 8;
+
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type load(const value_type *p)
+            {
+                return _mm256_loadu_ps(p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void store(value_type *p, vector_type v)
+            {
+                _mm256_storeu_ps(p, v);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void vertical(vector_type a, vector_type b, vector_type &lo, vector_type &hi)
+            {
+                __m256 swapped{_mm256_cmp_ps(b, a, _CMP_LT_OQ)};
+                lo = _mm256_blendv_ps(a, b, swapped);
+                hi = _mm256_blendv_ps(b, a, swapped);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void horizontal(vector_type v, vector_type p, vector_type &lo, vector_type &hi)
+            {
+                lo = _mm256_blendv_ps(v, p, _mm256_cmp_ps(p, v, _CMP_LT_OQ));
+                hi = _mm256_blendv_ps(v, p, _mm256_cmp_ps(v, p, _CMP_LT_OQ));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type permute(vector_type v, int j)
+            {
+                return j == 4 ? _mm256_permute2f128_ps(v, v, 0x01)
+                       : j == 2 ? _mm256_permute_ps(v, 0x4E)
+                                : _mm256_permute_ps(v, 0xB1);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static __m256i take_upper(int base, int j, int k)
+            {
+                return avx2_traits<std::int32_t>::take_upper(base, j, k);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type blend(vector_type a, vector_type b, __m256i m)
+            {
+                return _mm256_blendv_ps(a, b, _mm256_castsi256_ps(m));
+            }
+        };
+
+        template <>
+        struct avx2_traits<double>
+        {
+            using value_type = double;
+            using vector_type = __m256d;
+            static constexpr int width = 4;
+
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type load(const value_type *p)
+            {
+                return _mm256_loadu_pd(p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void store(value_type *p, vector_type v)
+            {
+                _mm256_storeu_pd(p, v);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void vertical(vector_type a, vector_type b, vector_type &lo, vector_type &hi)
+            {
+                __m256d swapped{_mm256_cmp_pd(b, a, _CMP_LT_OQ)};
+                lo = _mm256_blendv_pd(a, b, swapped);
+                hi = _mm256_blendv_pd(b, a, swapped);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void horizontal(vector_type v, vector_type p, vector_type &lo, vector_type &hi)
+            {
+                lo = _mm256_blendv_pd(v, p, _mm256_cmp_pd(p, v, _CMP_LT_OQ));
+                hi = _mm256_blendv_pd(v, p, _mm256_cmp_pd(v, p, _CMP_LT_OQ));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type permute(vector_type v, int j)
+            {
+                return j == 2 ? _mm256_permute2f128_pd(v, v, 0x01) : _mm256_permute_pd(v, 0x5);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static __m256i take_upper(int base, int j, int k)
+            {
+                return avx2_traits<std::int64_t>::take_upper(base, j, k);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type blend(vector_type a, vector_type b, __m256i m)
+            {
+                return _mm256_blendv_pd(a, b, _mm256_castsi256_pd(m));
+            }
+        };
+
+        // Unsigned lanes are stored with the sign bit flipped and sorted as signed.
+        template <>
+        struct avx2_traits<std::uint32_t> : avx2_traits<std::int32_t>
+        {
+            using value_type = std::uint32_t;
+
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type load(const value_type *p)
+            {
+                return _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)),
+                                        _mm256_set1_epi32(std::numeric_limits<std::int32_t>::min()));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void store(value_type *p, vector_type v)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(p),
+                                    _mm256_xor_si256(v, _mm256_set1_epi32(std::numeric_limits<std::int32_t>::min())));
+            }
+        };
+
+        template <>
+        struct avx2_traits<std::uint64_t> : avx2_traits<std::int64_t>
+        {
+            using value_type = std::uint64_t;
+
+            OMOTEURA_INTROSORT_TARGET_AVX2 static vector_type load(const value_type *p)
+            {
+                return _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)),
+                                        _mm256_set1_epi64x(std::numeric_limits<std::int64_t>::min()));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX2 static void store(value_type *p, vector_type v)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(p),
+                                    _mm256_xor_si256(v, _mm256_set1_epi64x(std::numeric_limits<std::int64_t>::min())));
+            }
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // sse42_traits<T>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <typename T>
+        struct sse42_traits;
+
+        template <>
+        struct sse42_traits<std::int32_t>
+        {
+            using value_type = std::int32_t;
+            using vector_type = __m128i;
+            static constexpr int width = 4;
+
+            OMOTEURA_INTROSORT_TARGET_SSE42 static vector_type load(const value_type *p)
+            {
+                return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static void store(value_type *p, vector_type v)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static void vertical(vector_type a, vector_type b, vector_type &lo, vector_type &hi)
+            {
+                lo = _mm_min_epi32(a, b);
+                hi = _mm_max_epi32(a, b);
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static void horizontal(vector_type v, vector_type p, vector_type &lo, vector_type &hi)
+            {
+                vertical(v, p, lo, hi);
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static vector_type permute(vector_type v, int j)
+            {
+                return j == 2 ? _mm_shuffle_epi32(v, 0x4E) : _mm_shuffle_epi32(v, 0xB1);
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static __m128i take_upper(int base, int j, int k)
+            {
+                __m128i index{_mm_add_epi32(_mm_set1_epi32(base), _mm_setr_epi32(0, 1, 2, 3))};
+                __m128i inUpper{_mm_cmpeq_epi32(_mm_and_si128(index, _mm_set1_epi32(j)), _mm_set1_epi32(j))};
+                __m128i inDescending{_mm_cmpeq_epi32(_mm_and_si128(index, _mm_set1_epi32(k)), _mm_set1_epi32(k))};
+                return _mm_xor_si128(inUpper, inDescending);
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static vector_type blend(vector_type a, vector_type b, __m128i m)
+            {
+                return _mm_blendv_epi8(a, b, m);
+            }
+        };
+
+        template <>
+        struct sse42_traits<std::int64_t>
+        {
+            using value_type = std::int64_t;
+            using vector_type = __m128i;
+            static constexpr int width = 2;
+
+            OMOTEURA_INTROSORT_TARGET_SSE42 static vector_type load(const value_type *p)
+            {
+                return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static void store(value_type *p, vector_type v)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static void vertical(vector_type a, vector_type b, vector_type &lo, vector_type &hi)
+            {
+                __m128i swapped{_mm_cmpgt_epi64(a, b)};
+                lo = _mm_blendv_epi8(a, b, swapped);
+                hi = _mm_blendv_epi8(b, a, swapped);
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static void horizontal(vector_type v, vector_type p, vector_type &lo, vector_type &hi)
+            {
+                vertical(v, p, lo, hi);
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static vector_type permute(vector_type v, int)
+            {
+                return _mm_shuffle_epi32(v, 0x4E);
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static __m128i take_upper(int base, int j, int k)
+            {
+                __m128i index{_mm_add_epi64(_mm_set1_epi64x(base), _mm_set_epi64x(1, 0))};
+                __m128i inUpper{_mm_cmpeq_epi64(_mm_and_si128(index, _mm_set1_epi64x(j)), _mm_set1_epi64x(j))};
+                __m128i inDescending{_mm_cmpeq_epi64(_mm_and_si128(index, _mm_set1_epi64x(k)), _mm_set1_epi64x(k))};
+                return _mm_xor_si128(inUpper, inDescending);
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static vector_type blend(vector_type a, vector_type b, __m128i m)
+            {
+                return _mm_blendv_epi8(a, b, m);
+            }
+        };
+
+        template <>
+        struct sse42_traits<float>
+        {
+            using value_type = float;
+            using vector_type = __m128;
+            static constexpr int width = 4;
+
+            OMOTEURA_INTROSORT_TARGET_SSE42 static vector_type load(const value_type *p)
+            {
+                return _mm_loadu_ps(p);
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static void store(value_type *p, vector_type v)
+            {
+                _mm_storeu_ps(p, v);
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static void vertical(vector_type a, vector_type b, vector_type &lo, vector_type &hi)
+            {
+                __m128 swapped{_mm_cmplt_ps(b, a)};
+                lo = _mm_blendv_ps(a, b, swapped);
+                hi = _mm_blendv_ps(b, a, swapped);
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static void horizontal(vector_type v, vector_type p, vector_type &lo, vector_type &hi)
+            {
+                lo = _mm_blendv_ps(v, p, _mm_cmplt_ps(p, v));
+                hi = _mm_blendv_ps(v, p, _mm_cmplt_ps(v, p));
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static vector_type permute(vector_type v, int j)
+            {
+                return j == 2 ? _mm_shuffle_ps(v, v, 0x4E) : _mm_shuffle_ps(v, v, 0xB1);
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static __m128i take_upper(int base, int j, int k)
+            {
+                return sse42_traits<std::int32_t>::take_upper(base, j, k);
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static vector_type blend(vector_type a, vector_type b, __m128i m)
+            {
+                return _mm_blendv_ps(a, b, _mm_castsi128_ps(m));
+            }
+        };
+
+        template <>
+        struct sse42_traits<double>
+        {
+            using value_type = double;
+            using vector_type = __m128d;
+            static constexpr int width = 2;
+
+            OMOTEURA_INTROSORT_TARGET_SSE42 static vector_type load(const value_type *p)
+            {
+                return _mm_loadu_pd(p);
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static void store(value_type *p, vector_type v)
+            {
+                _mm_storeu_pd(p, v);
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static void vertical(vector_type a, vector_type b, vector_type &lo, vector_type &hi)
+            {
+                __m128d swapped{_mm_cmplt_pd(b, a)};
+                lo = _mm_blendv_pd(a, b, swapped);
+                hi = _mm_blendv_pd(b, a, swapped);
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static void horizontal(vector_type v, vector_type p, vector_type &lo, vector_type &hi)
+            {
+                lo = _mm_blendv_pd(v, p, _mm_cmplt_pd(p, v));
+                hi = _mm_blendv_pd(v, p, _mm_cmplt_pd(v, p));
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static vector_type permute(vector_type v, int)
+            {
+                return _mm_shuffle_pd(v, v, 0x1);
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static __m128i take_upper(int base, int j, int k)
+            {
+                return sse42_traits<std::int64_t>::take_upper(base, j, k);
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static vector_type blend(vector_type a, vector_type b, __m128i m)
+            {
+                return _mm_blendv_pd(a, b, _mm_castsi128_pd(m));
+            }
+        };
+
+        template <>
+        struct sse42_traits<std::uint32_t> : sse42_traits<std::int32_t>
+        {
+            using value_type = std::uint32_t;
+
+            OMOTEURA_INTROSORT_TARGET_SSE42 static vector_type load(const value_type *p)
+            {
+                return _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)),
+                                     _mm_set1_epi32(std::numeric_limits<std::int32_t>::min()));
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static void store(value_type *p, vector_type v)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(p),
+                                 _mm_xor_si128(v, _mm_set1_epi32(std::numeric_limits<std::int32_t>::min())));
+            }
+        };
+
+        template <>
+        struct sse42_traits<std::uint64_t> : sse42_traits<std::int64_t>
+        {
+            using value_type = std::uint64_t;
+
+            OMOTEURA_INTROSORT_TARGET_SSE42 static vector_type load(const value_type *p)
+            {
+                return _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)),
+                                     _mm_set1_epi64x(std::numeric_limits<std::int64_t>::min()));
+            }
+            OMOTEURA_INTROSORT_TARGET_SSE42 static void store(value_type *p, vector_type v)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(p),
+                                 _mm_xor_si128(v, _mm_set1_epi64x(std::numeric_limits<std::int64_t>::min())));
+            }
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // avx512_traits<T>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Only the networks longer than network_max_size run on AVX-512, where twice the lanes
+        // fit in the registers. The masked forms with every lane set compile to the plain
+        // instructions, which GCC warns start from an undefined register.
+        template <typename T>
+        struct avx512_traits;
+
+        template <>
+        struct avx512_traits<std::int32_t>
+        {
+            using value_type = std::int32_t;
+            using vector_type = __m512i;
+            static constexpr int width = 16;
+            static constexpr __mmask16 all = 0xFFFF;
+
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type load(const value_type *p)
+            {
+                return _mm512_loadu_si512(p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store(value_type *p, vector_type v)
+            {
+                _mm512_storeu_si512(p, v);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void vertical(vector_type a, vector_type b, vector_type &lo, vector_type &hi)
+            {
+                lo = _mm512_maskz_min_epi32(all, a, b);
+                hi = _mm512_maskz_max_epi32(all, a, b);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void horizontal(vector_type v, vector_type p, vector_type &lo, vector_type &hi)
+            {
+                vertical(v, p, lo, hi);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type permute(vector_type v, int j)
+            {
+                return j == 8   ? _mm512_maskz_shuffle_i32x4(all, v, v, 0x4E)
+                       : j == 4 ? _mm512_maskz_shuffle_i32x4(all, v, v, 0xB1)
+                       : j == 2 ? _mm512_maskz_shuffle_epi32(all, v, _MM_PERM_BADC)
+                                : _mm512_maskz_shuffle_epi32(all, v, _MM_PERM_CDAB);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static __mmask16 take_upper(int base, int j, int k)
+            {
+                unsigned m{0};
+                for (int i = 0; i < width; ++i)
+                {
+                    m |= static_cast<unsigned>((((base + i) & j) != 0) != (((base + i) & k) != 0)) << i;
+                }
+                return static_cast<__mmask16>(m);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type blend(vector_type a, vector_type b, __mmask16 m)
+            {
+                return _mm512_mask_blend_epi32(m, a, b);
+            }
+        };
+
+        template <>
+        struct avx512_traits<float>
+        {
+            using value_type = float;
+            using vector_type = __m512;
+            static constexpr int width = 16;
+            static constexpr __mmask16 all = 0xFFFF;
+
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type load(const value_type *p)
+            {
+                return _mm512_loadu_ps(p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store(value_type *p, vector_type v)
+            {
+                _mm512_storeu_ps(p, v);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void vertical(vector_type a, vector_type b, vector_type &lo, vector_type &hi)
+            {
+                __mmask16 swapped{_mm512_cmp_ps_mask(b, a, _CMP_LT_OQ)};
+                lo = _mm512_mask_blend_ps(swapped, a, b);
+                hi = _mm512_mask_blend_ps(swapped, b, a);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void horizontal(vector_type v, vector_type p, vector_type &lo, vector_type &hi)
+            {
+                lo = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(p, v, _CMP_LT_OQ), v, p);
+                hi = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(v, p, _CMP_LT_OQ), v, p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type permute(vector_type v, int j)
+            {
+                return j == 8   ? _mm512_maskz_shuffle_f32x4(all, v, v, 0x4E)
+                       : j == 4 ? _mm512_maskz_shuffle_f32x4(all, v, v, 0xB1)
+                       : j == 2 ? _mm512_maskz_permute_ps(all, v, 0x4E)
+                                : _mm512_maskz_permute_ps(all, v, 0xB1);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static __mmask16 take_upper(int base, int j, int k)
+            {
+                return avx512_traits<std::int32_t>::take_upper(base, j, k);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type blend(vector_type a, vector_type b, __mmask16 m)
+            {
+                return _mm512_mask_blend_ps(m, a, b);
+            }
+        };
+
+        template <>
+        struct avx512_traits<std::int64_t>
+        {
+            using value_type = std::int64_t;
+            using vector_type = __m512i;
+            static constexpr int width = 8;
+            static constexpr __mmask8 all = 0xFF;
+
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type load(const value_type *p)
+            {
+                return _mm512_loadu_si512(p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store(value_type *p, vector_type v)
+            {
+                _mm512_storeu_si512(p, v);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void vertical(vector_type a, vector_type b, vector_type &lo, vector_type &hi)
+            {
+                lo = _mm512_maskz_min_epi64(all, a, b);
+                hi = _mm512_maskz_max_epi64(all, a, b);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void horizontal(vector_type v, vector_type p, vector_type &lo, vector_type &hi)
+            {
+                vertical(v, p, lo, hi);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type permute(vector_type v, int j)
+            {
+                return j == 4   ? _mm512_maskz_shuffle_i64x2(all, v, v, 0x4E)
+                       : j == 2 ? _mm512_maskz_shuffle_i64x2(all, v, v, 0xB1)
+                                : _mm512_maskz_permutex_epi64(all, v, 0xB1);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static __mmask8 take_upper(int base, int j, int k)
+            {
+                unsigned m{0};
+                for (int i = 0; i < width; ++i)
+                {
+                    m |= static_cast<unsigned>((((base + i) & j) != 0) != (((base + i) & k) != 0)) << i;
+                }
+                return static_cast<__mmask8>(m);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type blend(vector_type a, vector_type b, __mmask8 m)
+            {
+                return _mm512_mask_blend_epi64(m, a, b);
+            }
+        };
+
+        template <>
+        struct avx512_traits<double>
+        {
+            using value_type = double;
+            using vector_type = __m512d;
+            static constexpr int width = 8;
+            static constexpr __mmask8 all = 0xFF;
+
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type load(const value_type *p)
+            {
+                return _mm512_loadu_pd(p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store(value_type *p, vector_type v)
+            {
+                _mm512_storeu_pd(p, v);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void vertical(vector_type a, vector_type b, vector_type &lo, vector_type &hi)
+            {
+                __mmask8 swapped{_mm512_cmp_pd_mask(b, a, _CMP_LT_OQ)};
+                lo = _mm512_mask_blend_pd(swapped, a, b);
+                hi = _mm512_mask_blend_pd(swapped, b, a);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void horizontal(vector_type v, vector_type p, vector_type &lo, vector_type &hi)
+            {
+                lo = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(p, v, _CMP_LT_OQ), v, p);
+                hi = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(v, p, _CMP_LT_OQ), v, p);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type permute(vector_type v, int j)
+            {
+                return j == 4   ? _mm512_maskz_shuffle_f64x2(all, v, v, 0x4E)
+                       : j == 2 ? _mm512_maskz_shuffle_f64x2(all, v, v, 0xB1)
+                                : _mm512_maskz_permute_pd(all, v, 0x55);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static __mmask8 take_upper(int base, int j, int k)
+            {
+                return avx512_traits<std::int64_t>::take_upper(base, j, k);
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type blend(vector_type a, vector_type b, __mmask8 m)
+            {
+                return _mm512_mask_blend_pd(m, a, b);
+            }
+        };
+
+        template <>
+        struct avx512_traits<std::uint32_t> : avx512_traits<std::int32_t>
+        {
+            using value_type = std::uint32_t;
+
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type load(const value_type *p)
+            {
+                return _mm512_xor_si512(_mm512_loadu_si512(p), _mm512_set1_epi32(std::numeric_limits<std::int32_t>::min()));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store(value_type *p, vector_type v)
+            {
+                _mm512_storeu_si512(p, _mm512_xor_si512(v, _mm512_set1_epi32(std::numeric_limits<std::int32_t>::min())));
+            }
+        };
+
+        template <>
+        struct avx512_traits<std::uint64_t> : avx512_traits<std::int64_t>
+        {
+            using value_type = std::uint64_t;
+
+            OMOTEURA_INTROSORT_TARGET_AVX512 static vector_type load(const value_type *p)
+            {
+                return _mm512_xor_si512(_mm512_loadu_si512(p), _mm512_set1_epi64(std::numeric_limits<std::int64_t>::min()));
+            }
+            OMOTEURA_INTROSORT_TARGET_AVX512 static void store(value_type *p, vector_type v)
+            {
+                _mm512_storeu_si512(p, _mm512_xor_si512(v, _mm512_set1_epi64(std::numeric_limits<std::int64_t>::min())));
+            }
+        };
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+// The vectors never cross a call: the body below is always inlined into a kernel compiled for
+// their instruction set.
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // bitonic_network<Traits, N, Descending>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Bitonic sorting network over N elements held in N / width registers. Exchanges between
+        // registers are plain min/max; exchanges inside a register pair each lane with a permuted
+        // copy and blend the results.
+        template <typename Traits, int N, bool Descending>
+        OMOTEURA_INTROSORT_ALWAYS_INLINE void bitonic_network(typename Traits::value_type *data)
+        {
+            using V = typename Traits::vector_type;
+            constexpr int width = Traits::width;
+            constexpr int count = N / width;
+            static_assert(count > 0 && (count & (count - 1)) == 0, "N must be a power-of-two multiple of the width");
+            constexpr int logN = [] {
+                int log{0};
+                while ((1 << log) < N)
+                {
+                    ++log;
+                }
+                return log;
+            }();
+            V v[count];
+            for (int m = 0; m < count; ++m)
+            {
+                v[m] = Traits::load(data + m * width);
+            }
+            OMOTEURA_INTROSORT_UNROLL
+            for (int kLog = 1; kLog <= logN; ++kLog)
+            {
+                const int k{1 << kLog};
+                OMOTEURA_INTROSORT_UNROLL
+                for (int jLog = kLog - 1; jLog >= 0; --jLog)
+                {
+                    const int j{1 << jLog};
+                    OMOTEURA_INTROSORT_UNROLL
+                    for (int m = 0; m < count; ++m)
+                    {
+                        V lo;
+                        V hi;
+                        if (j >= width)
+                        {
+                            // j < N, so the partner is always one of the registers; the mask
+                            // only lets the compiler see that.
+                            int p{(m ^ (j / width)) & (count - 1)};
+                            if (p > m)
+                            {
+                                Traits::vertical(v[m], v[p], lo, hi);
+                                bool ascending{((m * width) & k) == 0};
+                                v[m] = ascending != Descending ? lo : hi;
+                                v[p] = ascending != Descending ? hi : lo;
+                            }
+                        }
+                        else
+                        {
+                            Traits::horizontal(v[m], Traits::permute(v[m], j), lo, hi);
+                            v[m] = Descending ? Traits::blend(hi, lo, Traits::take_upper(m * width, j, k))
+                                              : Traits::blend(lo, hi, Traits::take_upper(m * width, j, k));
+                        }
+                    }
+                }
+            }
+            for (int m = 0; m < count; ++m)
+            {
+                Traits::store(data + m * width, v[m]);
+            }
+        }
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // bitonic_sort_avx512<Traits, N, Descending> / bitonic_sort_avx2<Traits, N, Descending> /
+        // bitonic_sort_sse42<Traits, N, Descending>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <typename Traits, int N, bool Descending>
+        OMOTEURA_INTROSORT_TARGET_AVX512 void bitonic_sort_avx512(typename Traits::value_type *data)
+        {
+            bitonic_network<Traits, N, Descending>(data);
+        }
+
+        template <typename Traits, int N, bool Descending>
+        OMOTEURA_INTROSORT_TARGET_AVX2 void bitonic_sort_avx2(typename Traits::value_type *data)
+        {
+            bitonic_network<Traits, N, Descending>(data);
+        }
+
+        template <typename Traits, int N, bool Descending>
+        OMOTEURA_INTROSORT_TARGET_SSE42 void bitonic_sort_sse42(typename Traits::value_type *data)
+        {
+            bitonic_network<Traits, N, Descending>(data);
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // bitonic_sort_block<T, N, Descending>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Networks longer than network_max_size take AVX-512 where the CPU has it.
+        template <typename T, int N, bool Descending>
+        void bitonic_sort_block(T *data, simd_level level)
+        {
+            if constexpr (N > network_max_size)
+            {
+                if (level >= simd_level::avx512)
+                {
+                    bitonic_sort_avx512<avx512_traits<T>, N, Descending>(data);
+                    return;
+                }
+            }
+            if (level >= simd_level::avx2)
+            {
+                bitonic_sort_avx2<avx2_traits<T>, N, Descending>(data);
+            }
+            else
+            {
+                bitonic_sort_sse42<sse42_traits<T>, N, Descending>(data);
+            }
+        }
+#endif
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // network_sort<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Sorts up to MaxSize elements with a bitonic network of 8, 16, 32, 64 or, when MaxSize
+        // allows and the CPU has AVX-512, or AVX2 for 32-bit elements, 128 or 256 lanes, padding
+        // the unused lanes with the largest value. Returns false when the range has to be sorted
+        // otherwise: no SIMD support, an unsupported type or comparator, a range that is too
+        // long, or a NaN. Up to network_max_size elements, insertion_sort is the fallback.
+        template <int MaxSize = network_max_size, typename RandomAccessIterator, typename Compare>
+        bool network_sort(RandomAccessIterator first, RandomAccessIterator last, Compare)
+        {
+            static_assert(MaxSize == network_max_size || MaxSize == wide_network_max_size,
+                          "MaxSize must be network_max_size or wide_network_max_size");
+#if defined(OMOTEURA_INTROSORT_SIMD_X86)
+            using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            if constexpr (is_network_sortable<T, Compare>::value)
+            {
+                constexpr bool descending{!std::is_same<Compare, std::less<T>>::value &&
+                                          !std::is_same<Compare, std::less<>>::value};
+                auto n{last - first};
+                simd_level level{current_simd_level()};
+                // Without AVX-512, the wide networks of 64-bit elements lose to merging.
+                if (n > MaxSize || level == simd_level::none ||
+                    (n > network_max_size && level < (sizeof(T) == 4 ? simd_level::avx2 : simd_level::avx512)))
+                {
+                    return false;
+                }
+                constexpr T padding{std::numeric_limits<T>::has_infinity
+                                        ? (descending ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::infinity())
+                                        : (descending ? std::numeric_limits<T>::lowest() : std::numeric_limits<T>::max())};
+                alignas(32) T data[MaxSize];
+                int size{n <= 8 ? 8 : n <= 16 ? 16 : n <= 32 ? 32 : n <= 64 ? 64 : n <= 128 ? 128 : 256};
+                bool unordered{false};
+                for (int i = 0; i < n; ++i)
+                {
+                    data[i] = first[i];
+                    unordered = unordered || data[i] != data[i];
+                }
+                if (unordered)
+                {
+                    // NaN blocks every exchange it takes part in, so padding could end up
+                    // among the first n lanes.
+                    return false;
+                }
+                for (int i = static_cast<int>(n); i < size; ++i)
+                {
+                    data[i] = padding;
+                }
+                switch (size)
+                {
+                case 8:
+                    bitonic_sort_block<T, 8, descending>(data, level);
+                    break;
+                case 16:
+                    bitonic_sort_block<T, 16, descending>(data, level);
+                    break;
+                case 32:
+                    bitonic_sort_block<T, 32, descending>(data, level);
+                    break;
+                case 64:
+                    bitonic_sort_block<T, 64, descending>(data, level);
+                    break;
+                case 128:
+                    if constexpr (MaxSize > network_max_size)
+                    {
+                        bitonic_sort_block<T, 128, descending>(data, level);
+                    }
+                    break;
+                default:
+                    if constexpr (MaxSize > network_max_size)
+                    {
+                        bitonic_sort_block<T, 256, descending>(data, level);
+                    }
+                    break;
+                }
+                for (int i = 0; i < n; ++i)
+                {
+                    first[i] = data[i];
+                }
+                return true;
+            }
+            else
+            {
+                static_cast<void>(first);
+                static_cast<void>(last);
+                return false;
+            }
+#else
+            static_cast<void>(first);
+            static_cast<void>(last);
+            return false;
+#endif
+        }
+    } // namespace detail
+} // namespace omoteura
@@ -0,0 +1,470 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// stable_sort.h
+// Copyright (c) 2025 ozk
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "intro_sort.h"
+
+namespace omoteura
+{
+    template <typename RandomAccessIterator, typename Compare>
+    void stable_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp);
+    template <typename RandomAccessIterator, typename Compare>
+    void stable_sort(RandomAccessIterator first,
+                     RandomAccessIterator last,
+                     Compare comp,
+                     std::vector<typename std::iterator_traits<RandomAccessIterator>::value_type> &buffer);
+
+    namespace detail
+    {
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // merge_without_buffer<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Stable in-place merge by rotation, used when no buffer can be obtained.
+        template <typename RandomAccessIterator, typename Compare>
+        void merge_without_buffer(RandomAccessIterator first,
+                                  RandomAccessIterator middle,
+                                  RandomAccessIterator last,
+                                  Compare comp)
+        {
+            while (first != middle && middle != last)
+            {
+                if (last - first == 2)
+                {
+                    if (comp(*middle, *first))
+                    {
+                        using std::swap;
+                        swap(*first, *middle);
+                    }
+                    return;
+                }
+                RandomAccessIterator cutA;
+                RandomAccessIterator cutB;
+                if (middle - first > last - middle)
+                {
+                    cutA = first + (middle - first) / 2;
+                    cutB = std::lower_bound(middle, last, *cutA, comp);
+                }
+                else
+                {
+                    cutB = middle + (last - middle) / 2;
+                    cutA = std::upper_bound(first, middle, *cutB, comp);
+                }
+                RandomAccessIterator newMiddle{std::rotate(cutA, middle, cutB)};
+                // Recurse into the shorter half and loop on the longer one.
+                if ((newMiddle - first) < (last - newMiddle))
+                {
+                    merge_without_buffer<RandomAccessIterator, Compare>(first, cutA, newMiddle, comp);
+                    first = newMiddle;
+                    middle = cutB;
+                }
+                else
+                {
+                    merge_without_buffer<RandomAccessIterator, Compare>(newMiddle, cutB, last, comp);
+                    last = newMiddle;
+                    middle = cutA;
+                }
+            }
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // tim_sorter<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Timsort: natural runs, extended to a minimum length with insertion_sort, are pushed on
+        // a stack whose lengths are kept roughly Fibonacci-like so merges stay balanced. Merges
+        // switch to galloping when one side keeps winning.
+        template <typename RandomAccessIterator, typename Compare>
+        class tim_sorter
+        {
+        public:
+            using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+
+            tim_sorter(RandomAccessIterator first, Compare comp, std::vector<T> &buffer)
+                : first_(first), comp_(comp), buffer_(buffer)
+            {
+            }
+
+            void sort(Diff n)
+            {
+                Diff minRun{min_run_length(n)};
+                Diff base{0};
+                while (base < n)
+                {
+                    Diff length{count_run(first_ + base, first_ + n)};
+                    if (length < minRun)
+                    {
+                        Diff forced{std::min(minRun, n - base)};
+                        insertion_sort(first_ + base, first_ + (base + forced), comp_);
+                        length = forced;
+                    }
+                    assert(runCount_ < maxRuns);
+                    runs_[runCount_++] = run{base, length};
+                    merge_collapse();
+                    base += length;
+                }
+                merge_force_collapse();
+            }
+
+        private:
+            struct run
+            {
+                Diff base;
+                Diff length;
+            };
+
+            // Enough for any length representable in 64 bits.
+            static constexpr int maxRuns = 85;
+            static constexpr int minGallopDefault = 7;
+
+            static Diff min_run_length(Diff n)
+            {
+                Diff r{0};
+                while (n >= 64)
+                {
+                    r |= n & 1;
+                    n >>= 1;
+                }
+                return n + r;
+            }
+
+            // Returns the length of the run starting at first, reversing it if it is strictly
+            // descending.
+            Diff count_run(RandomAccessIterator first, RandomAccessIterator last)
+            {
+                RandomAccessIterator i{first + 1};
+                if (i == last)
+                {
+                    return 1;
+                }
+                if (comp_(*i, *first))
+                {
+                    while (++i != last && comp_(*i, *(i - 1)))
+                    {
+                    }
+                    std::reverse(first, i);
+                }
+                else
+                {
+                    while (++i != last && !comp_(*i, *(i - 1)))
+                    {
+                    }
+                }
+                return i - first;
+            }
+
+            void merge_collapse()
+            {
+                while (runCount_ > 1)
+                {
+                    int n{runCount_ - 2};
+                    if ((n > 0 && runs_[n - 1].length <= runs_[n].length + runs_[n + 1].length) ||
+                        (n > 1 && runs_[n - 2].length <= runs_[n - 1].length + runs_[n].length))
+                    {
+                        if (runs_[n - 1].length < runs_[n + 1].length)
+                        {
+                            --n;
+                        }
+                    }
+                    else if (runs_[n].length > runs_[n + 1].length)
+                    {
+                        break;
+                    }
+                    merge_at(n);
+                }
+            }
+
+            void merge_force_collapse()
+            {
+                while (runCount_ > 1)
+                {
+                    int n{runCount_ - 2};
+                    if (n > 0 && runs_[n - 1].length < runs_[n + 1].length)
+                    {
+                        --n;
+                    }
+                    merge_at(n);
+                }
+            }
+
+            void merge_at(int i)
+            {
+                RandomAccessIterator a{first_ + runs_[i].base};
+                RandomAccessIterator b{first_ + runs_[i + 1].base};
+                RandomAccessIterator end{b + runs_[i + 1].length};
+                runs_[i].length += runs_[i + 1].length;
+                if (i == runCount_ - 3)
+                {
+                    runs_[i + 1] = runs_[i + 2];
+                }
+                --runCount_;
+
+                // Elements of a not greater than *b and elements of b not less than *(b - 1)
+                // are already in place.
+                Compare &comp{comp_};
+                a = gallop_forward(a, b, [&comp, b](const T &x) { return !comp(*b, x); });
+                if (a == b)
+                {
+                    return;
+                }
+                end = gallop_backward(b, end, [&comp, b](const T &x) { return comp(x, *(b - 1)); });
+                if (b == end)
+                {
+                    return;
+                }
+
+                Diff lengthA{b - a};
+                Diff lengthB{end - b};
+                if (!reserve_buffer(std::min(lengthA, lengthB)))
+                {
+                    merge_without_buffer(a, b, end, comp_);
+                }
+                else if (lengthA <= lengthB)
+                {
+                    merge_low(a, b, end);
+                }
+                else
+                {
+                    merge_high(a, b, end);
+                }
+            }
+
+            bool reserve_buffer(Diff n)
+            {
+                if (buffer_.capacity() < static_cast<std::size_t>(n))
+                {
+                    try
+                    {
+                        buffer_.reserve(static_cast<std::size_t>(n));
+                    }
+                    catch (const std::bad_alloc &)
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            // Moves [a, b) to the buffer and merges forward.
+            void merge_low(RandomAccessIterator a, RandomAccessIterator b, RandomAccessIterator end)
+            {
+                buffer_.clear();
+                buffer_.insert(buffer_.end(), std::make_move_iterator(a), std::make_move_iterator(b));
+                typename std::vector<T>::iterator cursor1{buffer_.begin()};
+                typename std::vector<T>::iterator end1{buffer_.end()};
+                RandomAccessIterator cursor2{b};
+                RandomAccessIterator dest{a};
+                Compare &comp{comp_};
+                try
+                {
+                    while (cursor1 != end1 && cursor2 != end)
+                    {
+                        Diff count1{0};
+                        Diff count2{0};
+                        while (cursor1 != end1 && cursor2 != end)
+                        {
+                            if (comp(*cursor2, *cursor1))
+                            {
+                                *dest++ = std::move(*cursor2++);
+                                count1 = 0;
+                                if (++count2 >= minGallop_)
+                                {
+                                    break;
+                                }
+                            }
+                            else
+                            {
+                                *dest++ = std::move(*cursor1++);
+                                count2 = 0;
+                                if (++count1 >= minGallop_)
+                                {
+                                    break;
+                                }
+                            }
+                        }
+                        while (cursor1 != end1 && cursor2 != end)
+                        {
+                            typename std::vector<T>::iterator next1{
+                                gallop_forward(cursor1, end1, [&comp, cursor2](const T &x) { return !comp(*cursor2, x); })};
+                            count1 = next1 - cursor1;
+                            dest = std::move(cursor1, next1, dest);
+                            cursor1 = next1;
+                            if (cursor1 == end1)
+                            {
+                                break;
+                            }
+                            *dest++ = std::move(*cursor2++);
+                            if (cursor2 == end)
+                            {
+                                break;
+                            }
+                            RandomAccessIterator next2{
+                                gallop_forward(cursor2, end, [&comp, cursor1](const T &x) { return comp(x, *cursor1); })};
+                            count2 = next2 - cursor2;
+                            dest = std::move(cursor2, next2, dest);
+                            cursor2 = next2;
+                            if (cursor2 == end)
+                            {
+                                break;
+                            }
+                            *dest++ = std::move(*cursor1++);
+                            minGallop_ = std::max(1, minGallop_ - 1);
+                            if (count1 < minGallopDefault && count2 < minGallopDefault)
+                            {
+                                minGallop_ += 2;
+                                break;
+                            }
+                        }
+                    }
+                    std::move(cursor1, end1, dest);
+                }
+                catch (...)
+                {
+                    // dest + (end1 - cursor1) == cursor2, so the hole is exactly filled.
+                    std::move(cursor1, end1, dest);
+                    throw;
+                }
+            }
+
+            // Moves [b, end) to the buffer and merges backward.
+            void merge_high(RandomAccessIterator a, RandomAccessIterator b, RandomAccessIterator end)
+            {
+                buffer_.clear();
+                buffer_.insert(buffer_.end(), std::make_move_iterator(b), std::make_move_iterator(end));
+                typename std::vector<T>::iterator begin2{buffer_.begin()};
+                typename std::vector<T>::iterator cursor2{buffer_.end()};
+                RandomAccessIterator cursor1{b};
+                RandomAccessIterator dest{end};
+                Compare &comp{comp_};
+                try
+                {
+                    while (cursor1 != a && cursor2 != begin2)
+                    {
+                        Diff count1{0};
+                        Diff count2{0};
+                        while (cursor1 != a && cursor2 != begin2)
+                        {
+                            if (comp(*(cursor2 - 1), *(cursor1 - 1)))
+                            {
+                                *--dest = std::move(*--cursor1);
+                                count2 = 0;
+                                if (++count1 >= minGallop_)
+                                {
+                                    break;
+                                }
+                            }
+                            else
+                            {
+                                *--dest = std::move(*--cursor2);
+                                count1 = 0;
+                                if (++count2 >= minGallop_)
+                                {
+                                    break;
+                                }
+                            }
+                        }
+                        while (cursor1 != a && cursor2 != begin2)
+                        {
+                            const T &key2{*(cursor2 - 1)};
+                            RandomAccessIterator next1{
+                                gallop_backward(a, cursor1, [&comp, &key2](const T &x) { return !comp(key2, x); })};
+                            count1 = cursor1 - next1;
+                            dest = std::move_backward(next1, cursor1, dest);
+                            cursor1 = next1;
+                            if (cursor1 == a)
+                            {
+                                break;
+                            }
+                            *--dest = std::move(*--cursor2);
+                            if (cursor2 == begin2)
+                            {
+                                break;
+                            }
+                            RandomAccessIterator key1{cursor1 - 1};
+                            typename std::vector<T>::iterator next2{
+                                gallop_backward(begin2, cursor2, [&comp, key1](const T &x) { return comp(x, *key1); })};
+                            count2 = cursor2 - next2;
+                            dest = std::move_backward(next2, cursor2, dest);
+                            cursor2 = next2;
+                            if (cursor2 == begin2)
+                            {
+                                break;
+                            }
+                            *--dest = std::move(*--cursor1);
+                            minGallop_ = std::max(1, minGallop_ - 1);
+                            if (count1 < minGallopDefault && count2 < minGallopDefault)
+                            {
+                                minGallop_ += 2;
+                                break;
+                            }
+                        }
+                    }
+                    std::move_backward(begin2, cursor2, dest);
+                }
+                catch (...)
+                {
+                    // dest - (cursor2 - begin2) == cursor1, so the hole is exactly filled.
+                    std::move_backward(begin2, cursor2, dest);
+                    throw;
+                }
+            }
+
+            RandomAccessIterator first_;
+            Compare comp_;
+            std::vector<T> &buffer_;
+            run runs_[maxRuns]{};
+            int runCount_{0};
+            int minGallop_{minGallopDefault};
+        };
+    } // namespace detail
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // stable_sort<RandomAccessIterator>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename RandomAccessIterator>
+    void stable_sort(RandomAccessIterator first, RandomAccessIterator last)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        omoteura::stable_sort(first, last, std::less<T>{});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // stable_sort<RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename RandomAccessIterator, typename Compare>
+    void stable_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        std::vector<T> buffer;
+        omoteura::stable_sort(first, last, comp, buffer);
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // stable_sort<RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // buffer is scratch space that only ever grows; reuse it across calls to avoid allocating.
+    template <typename RandomAccessIterator, typename Compare>
+    void stable_sort(RandomAccessIterator first,
+                     RandomAccessIterator last,
+                     Compare comp,
+                     std::vector<typename std::iterator_traits<RandomAccessIterator>::value_type> &buffer)
+    {
+        using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+        Diff n{last - first};
+        if (n >= 2)
+        {
+            detail::tim_sorter<RandomAccessIterator, Compare> sorter{first, comp, buffer};
+            sorter.sort(n);
+        }
+    }
+} // namespace omoteura
@@ -0,0 +1,475 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// static_sort.h
+// Copyright (c) 2025 ozk
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace omoteura
+{
+    template <std::size_t N, typename RandomAccessIterator, typename Compare>
+    constexpr void static_sort(RandomAccessIterator first, Compare comp);
+    template <std::size_t N, typename RandomAccessIterator>
+    constexpr void static_sort(RandomAccessIterator first);
+    template <typename T, std::size_t N, typename Compare>
+    constexpr void static_sort(std::array<T, N> &items, Compare comp);
+    template <typename T, std::size_t N>
+    constexpr void static_sort(std::array<T, N> &items);
+
+    namespace detail
+    {
+        // One comparator of a sorting network: afterwards the element at low does not compare
+        // greater than the one at high.
+        struct network_exchange
+        {
+            int low;
+            int high;
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // batcher_network
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Batcher's odd-even merge sort for n inputs, with the comparators beyond n left out.
+        // Writes the comparators to exchanges unless it is null and returns how many there are.
+        constexpr std::size_t batcher_network(std::size_t n, network_exchange *exchanges)
+        {
+            std::size_t count{0};
+            for (std::size_t p = 1; p < n; p *= 2)
+            {
+                for (std::size_t k = p; k >= 1; k /= 2)
+                {
+                    for (std::size_t j = k % p; j + k < n; j += 2 * k)
+                    {
+                        for (std::size_t i = 0; i < k && i + j + k < n; ++i)
+                        {
+                            if ((i + j) / (2 * p) == (i + j + k) / (2 * p))
+                            {
+                                if (exchanges != nullptr)
+                                {
+                                    exchanges[count] = {static_cast<int>(i + j), static_cast<int>(i + j + k)};
+                                }
+                                ++count;
+                            }
+                        }
+                    }
+                }
+            }
+            return count;
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // make_batcher_network<N>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <std::size_t N>
+        constexpr auto make_batcher_network()
+        {
+            std::array<network_exchange, batcher_network(N, nullptr)> exchanges{};
+            batcher_network(N, exchanges.data());
+            return exchanges;
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // static_network<N>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // The comparators static_sort<N> runs, one layer of independent ones per line. Up to 16
+        // inputs these are the smallest networks known, which for up to 12 inputs are proven
+        // optimal; beyond that Batcher's network is generated at compile time.
+        template <std::size_t N>
+        struct static_network
+        {
+            static constexpr auto exchanges{make_batcher_network<N>()};
+        };
+
+        template <>
+        struct static_network<2>
+        {
+            static constexpr std::array<network_exchange, 1> exchanges{{
+                {0, 1},
+            }};
+        };
+
+        template <>
+        struct static_network<3>
+        {
+            static constexpr std::array<network_exchange, 3> exchanges{{
+                {0, 2},
+                {0, 1},
+                {1, 2},
+            }};
+        };
+
+        template <>
+        struct static_network<4>
+        {
+            static constexpr std::array<network_exchange, 5> exchanges{{
+                {0, 1}, {2, 3},
+                {0, 2}, {1, 3},
+                {1, 2},
+            }};
+        };
+
+        template <>
+        struct static_network<5>
+        {
+            static constexpr std::array<network_exchange, 9> exchanges{{
+                {1, 3}, {2, 4},
+                {1, 2}, {3, 4},
+                {0, 3},
+                {0, 1}, {2, 3},
+                {1, 2}, {3, 4},
+            }};
+        };
+
+        template <>
+        struct static_network<6>
+        {
+            static constexpr std::array<network_exchange, 12> exchanges{{
+                {0, 5}, {1, 3}, {2, 4},
+                {1, 2}, {3, 4},
+                {0, 3}, {2, 5},
+                {0, 1}, {2, 3}, {4, 5},
+                {1, 2}, {3, 4},
+            }};
+        };
+
+        template <>
+        struct static_network<7>
+        {
+            static constexpr std::array<network_exchange, 16> exchanges{{
+                {0, 1}, {2, 3}, {4, 5},
+                {0, 2}, {1, 3}, {4, 6},
+                {1, 2}, {5, 6},
+                {0, 4}, {1, 5}, {2, 6},
+                {2, 4}, {3, 5},
+                {1, 2}, {3, 4}, {5, 6},
+            }};
+        };
+
+        template <>
+        struct static_network<8>
+        {
+            static constexpr std::array<network_exchange, 19> exchanges{{
+                {0, 1}, {2, 3}, {4, 5}, {6, 7},
+                {0, 2}, {1, 3}, {4, 6}, {5, 7},
+                {1, 2}, {5, 6},
+                {0, 4}, {1, 5}, {2, 6}, {3, 7},
+                {2, 4}, {3, 5},
+                {1, 2}, {3, 4}, {5, 6},
+            }};
+        };
+
+        template <>
+        struct static_network<9>
+        {
+            static constexpr std::array<network_exchange, 25> exchanges{{
+                {0, 3}, {1, 7}, {2, 5}, {4, 8},
+                {0, 7}, {2, 4}, {3, 8}, {5, 6},
+                {0, 2}, {1, 3}, {4, 5}, {7, 8},
+                {1, 4}, {3, 6}, {5, 7},
+                {0, 1}, {2, 4}, {3, 5}, {6, 8},
+                {2, 3}, {4, 5}, {6, 7},
+                {1, 2}, {3, 4}, {5, 6},
+            }};
+        };
+
+        template <>
+        struct static_network<10>
+        {
+            static constexpr std::array<network_exchange, 29> exchanges{{
+                {0, 8}, {1, 9}, {2, 7}, {3, 5}, {4, 6},
+                {0, 2}, {1, 4}, {5, 8}, {7, 9},
+                {0, 3}, {2, 4}, {5, 7}, {6, 9},
+                {0, 1}, {3, 6}, {8, 9},
+                {1, 5}, {2, 3}, {4, 8}, {6, 7},
+                {1, 2}, {3, 5}, {4, 6}, {7, 8},
+                {2, 3}, {4, 5}, {6, 7},
+                {3, 4}, {5, 6},
+            }};
+        };
+
+        template <>
+        struct static_network<11>
+        {
+            static constexpr std::array<network_exchange, 35> exchanges{{
+                {0, 9}, {1, 6}, {2, 4}, {3, 7}, {5, 8},
+                {0, 1}, {3, 5}, {4, 10}, {6, 9}, {7, 8},
+                {1, 3}, {2, 5}, {4, 7}, {8, 10},
+                {0, 4}, {1, 2}, {3, 7}, {5, 9}, {6, 8},
+                {0, 1}, {2, 6}, {4, 5}, {7, 8}, {9, 10},
+                {2, 4}, {3, 6}, {5, 7}, {8, 9},
+                {1, 2}, {3, 4}, {5, 6}, {7, 8},
+                {2, 3}, {4, 5}, {6, 7},
+            }};
+        };
+
+        template <>
+        struct static_network<12>
+        {
+            static constexpr std::array<network_exchange, 39> exchanges{{
+                {0, 8}, {1, 7}, {2, 6}, {3, 11}, {4, 10}, {5, 9},
+                {0, 1}, {2, 5}, {3, 4}, {6, 9}, {7, 8}, {10, 11},
+                {0, 2}, {1, 6}, {5, 10}, {9, 11},
+                {0, 3}, {1, 2}, {4, 6}, {5, 7}, {8, 11}, {9, 10},
+                {1, 4}, {3, 5}, {6, 8}, {7, 10},
+                {1, 3}, {2, 5}, {6, 9}, {8, 10},
+                {2, 3}, {4, 5}, {6, 7}, {8, 9},
+                {4, 6}, {5, 7},
+                {3, 4}, {5, 6}, {7, 8},
+            }};
+        };
+
+        template <>
+        struct static_network<13>
+        {
+            static constexpr std::array<network_exchange, 45> exchanges{{
+                {0, 12}, {1, 10}, {2, 9}, {3, 7}, {5, 11}, {6, 8},
+                {1, 6}, {2, 3}, {4, 11}, {7, 9}, {8, 10},
+                {0, 4}, {1, 2}, {3, 6}, {7, 8}, {9, 10}, {11, 12},
+                {4, 6}, {5, 9}, {8, 11}, {10, 12},
+                {0, 5}, {3, 8}, {4, 7}, {6, 11}, {9, 10},
+                {0, 1}, {2, 5}, {6, 9}, {7, 8}, {10, 11},
+                {1, 3}, {2, 4}, {5, 6}, {9, 10},
+                {1, 2}, {3, 4}, {5, 7}, {6, 8},
+                {2, 3}, {4, 5}, {6, 7}, {8, 9},
+                {3, 4}, {5, 6},
+            }};
+        };
+
+        template <>
+        struct static_network<14>
+        {
+            static constexpr std::array<network_exchange, 51> exchanges{{
+                {0, 1}, {2, 3}, {4, 5}, {6, 7}, {8, 9}, {10, 11}, {12, 13},
+                {0, 2}, {1, 3}, {4, 8}, {5, 9}, {10, 12}, {11, 13},
+                {0, 4}, {1, 2}, {3, 7}, {5, 8}, {6, 10}, {9, 13}, {11, 12},
+                {0, 6}, {1, 5}, {3, 9}, {4, 10}, {7, 13}, {8, 12},
+                {2, 10}, {3, 11}, {4, 6}, {7, 9},
+                {1, 3}, {2, 8}, {5, 11}, {6, 7}, {10, 12},
+                {1, 4}, {2, 6}, {3, 5}, {7, 11}, {8, 10}, {9, 12},
+                {2, 4}, {3, 6}, {5, 8}, {7, 10}, {9, 11},
+                {3, 4}, {5, 6}, {7, 8}, {9, 10},
+                {6, 7},
+            }};
+        };
+
+        template <>
+        struct static_network<16>
+        {
+            static constexpr std::array<network_exchange, 60> exchanges{{
+                {0, 13}, {1, 12}, {2, 15}, {3, 14}, {4, 8}, {5, 6}, {7, 11}, {9, 10},
+                {0, 5}, {1, 7}, {2, 9}, {3, 4}, {6, 13}, {8, 14}, {10, 15}, {11, 12},
+                {0, 1}, {2, 3}, {4, 5}, {6, 8}, {7, 9}, {10, 11}, {12, 13}, {14, 15},
+                {0, 2}, {1, 3}, {4, 10}, {5, 11}, {6, 7}, {8, 9}, {12, 14}, {13, 15},
+                {1, 2}, {3, 12}, {4, 6}, {5, 7}, {8, 10}, {9, 11}, {13, 14},
+                {1, 4}, {2, 6}, {5, 8}, {7, 10}, {9, 13}, {11, 14},
+                {2, 4}, {3, 6}, {9, 12}, {11, 13},
+                {3, 5}, {6, 8}, {7, 9}, {10, 12},
+                {3, 4}, {5, 6}, {7, 8}, {9, 10}, {11, 12},
+                {6, 7}, {8, 9},
+            }};
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // prune_network<N, M>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // The network for M inputs with the comparators that touch wires N and above removed,
+        // which sorts N inputs: those wires would only ever hold elements greater than the rest.
+        template <std::size_t N, std::size_t M>
+        constexpr auto prune_network()
+        {
+            constexpr std::size_t count{[] {
+                std::size_t kept{0};
+                for (const network_exchange &exchange : static_network<M>::exchanges)
+                {
+                    kept += static_cast<std::size_t>(exchange.high) < N ? 1 : 0;
+                }
+                return kept;
+            }()};
+            std::array<network_exchange, count> exchanges{};
+            std::size_t k{0};
+            for (const network_exchange &exchange : static_network<M>::exchanges)
+            {
+                if (static_cast<std::size_t>(exchange.high) < N)
+                {
+                    exchanges[k++] = exchange;
+                }
+            }
+            return exchanges;
+        }
+
+        template <>
+        struct static_network<15>
+        {
+            static constexpr auto exchanges{prune_network<15, 16>()};
+        };
+
+        // Elements that static_sort copies into locals and exchanges with two conditional moves
+        // each, instead of a branch and three moves through the iterator.
+        template <typename T>
+        struct is_register_sortable
+            : std::bool_constant<std::is_trivially_copyable<T>::value && std::is_default_constructible<T>::value &&
+                                 sizeof(T) <= 2 * sizeof(void *)>
+        {
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // select_exchange<T, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <typename T, typename Compare>
+        constexpr void select_exchange(T &a, T &b, Compare &comp)
+        {
+            bool swapped{comp(b, a)};
+            T low{swapped ? b : a};
+            T high{swapped ? a : b};
+            a = low;
+            b = high;
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // move_exchange<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <typename RandomAccessIterator, typename Compare>
+        constexpr void move_exchange(RandomAccessIterator a, RandomAccessIterator b, Compare &comp)
+        {
+            using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            if (comp(*b, *a))
+            {
+                T value{std::move(*a)};
+                *a = std::move(*b);
+                *b = std::move(value);
+            }
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // select_network<N, T, Compare, K...>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Runs static_network<N> over values, every comparator expanded with constant indices.
+        template <std::size_t N, typename T, typename Compare, std::size_t... K>
+        constexpr void select_network(T *values, Compare &comp, std::index_sequence<K...>)
+        {
+            (select_exchange(values[static_network<N>::exchanges[K].low],
+                             values[static_network<N>::exchanges[K].high],
+                             comp),
+             ...);
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // select_sort<N, RandomAccessIterator, Compare, I...>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Loads the N elements into locals, runs the network on them and stores them back.
+        template <std::size_t N, typename RandomAccessIterator, typename Compare, std::size_t... I>
+        constexpr void select_sort(RandomAccessIterator first, Compare &comp, std::index_sequence<I...>)
+        {
+            using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            using Diff = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+            T values[N]{first[static_cast<Diff>(I)]...};
+            select_network<N>(values, comp, std::make_index_sequence<static_network<N>::exchanges.size()>{});
+            ((first[static_cast<Diff>(I)] = values[I]), ...);
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // move_network<N, RandomAccessIterator, Compare, K...>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <std::size_t N, typename RandomAccessIterator, typename Compare, std::size_t... K>
+        constexpr void move_network(RandomAccessIterator first, Compare &comp, std::index_sequence<K...>)
+        {
+            (move_exchange(first + static_network<N>::exchanges[K].low,
+                           first + static_network<N>::exchanges[K].high,
+                           comp),
+             ...);
+        }
+
+        // Longest range fixed_network_sort accepts.
+        constexpr int fixed_network_max_size = 16;
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // fixed_network_sort<RandomAccessIterator, Compare>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Sorts n <= 16 elements, n known only at run time, with static_sort<n>.
+        template <typename RandomAccessIterator, typename Compare>
+        void fixed_network_sort(RandomAccessIterator first, int n, Compare comp)
+        {
+            switch (n)
+            {
+                case 2: static_sort<2>(first, comp); break;
+                case 3: static_sort<3>(first, comp); break;
+                case 4: static_sort<4>(first, comp); break;
+                case 5: static_sort<5>(first, comp); break;
+                case 6: static_sort<6>(first, comp); break;
+                case 7: static_sort<7>(first, comp); break;
+                case 8: static_sort<8>(first, comp); break;
+                case 9: static_sort<9>(first, comp); break;
+                case 10: static_sort<10>(first, comp); break;
+                case 11: static_sort<11>(first, comp); break;
+                case 12: static_sort<12>(first, comp); break;
+                case 13: static_sort<13>(first, comp); break;
+                case 14: static_sort<14>(first, comp); break;
+                case 15: static_sort<15>(first, comp); break;
+                case 16: static_sort<16>(first, comp); break;
+                default: break;
+            }
+        }
+    } // namespace detail
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // static_sort<N, RandomAccessIterator, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Sorts the N elements from first with a sorting network fixed at compile time, fully
+    // unrolled, so the comparisons made do not depend on the data. Small trivially copyable
+    // elements are sorted in locals with conditional moves and no branches; others are swapped
+    // through the iterator. Usable in constant expressions when comp and the element type are.
+    template <std::size_t N, typename RandomAccessIterator, typename Compare>
+    constexpr void static_sort(RandomAccessIterator first, Compare comp)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        if constexpr (N < 2)
+        {
+            return;
+        }
+        else if constexpr (detail::is_register_sortable<T>::value)
+        {
+            detail::select_sort<N>(first, comp, std::make_index_sequence<N>{});
+        }
+        else
+        {
+            detail::move_network<N>(first,
+                                    comp,
+                                    std::make_index_sequence<detail::static_network<N>::exchanges.size()>{});
+        }
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // static_sort<N, RandomAccessIterator>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <std::size_t N, typename RandomAccessIterator>
+    constexpr void static_sort(RandomAccessIterator first)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        static_sort<N>(first, std::less<T>{});
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // static_sort<T, N, Compare>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename T, std::size_t N, typename Compare>
+    constexpr void static_sort(std::array<T, N> &items, Compare comp)
+    {
+        static_sort<N>(items.begin(), comp);
+    }
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // static_sort<T, N>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    template <typename T, std::size_t N>
+    constexpr void static_sort(std::array<T, N> &items)
+    {
+        static_sort<N>(items.begin(), std::less<T>{});
+    }
+} // namespace omoteura
@@ -0,0 +1,375 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// string_sort.h
+// Copyright (c) 2025 ozk
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "intro_sort.h"
+
+namespace omoteura
+{
+    template <typename RandomAccessIterator>
+    void string_sort(RandomAccessIterator first, RandomAccessIterator last);
+
+    namespace detail
+    {
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // is_string_sortable<T>
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        template <typename T>
+        struct is_string_sortable
+            : std::integral_constant<bool,
+                                     std::is_same<T, std::string>::value ||
+                                         std::is_same<T, std::string_view>::value ||
+                                         std::is_same<T, const char *>::value || std::is_same<T, char *>::value>
+        {
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // string_bytes
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        inline std::string_view string_bytes(const std::string &s)
+        {
+            return std::string_view{s.data(), s.size()};
+        }
+
+        inline std::string_view string_bytes(std::string_view s)
+        {
+            return s;
+        }
+
+        inline std::string_view string_bytes(const char *s)
+        {
+            return std::string_view{s};
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // string_entry
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // A string being sorted, with the 8 bytes at the current depth cached big-endian in word
+        // and zero-padded past the end. All strings of a range share their first depth bytes, so
+        // (word, clip) orders them by the next 8 bytes without touching the heap.
+        struct string_entry
+        {
+            std::uint64_t word;
+            const unsigned char *data;
+            std::size_t size;
+            std::size_t index;
+        };
+
+        // Strings of at most this many elements are finished by insertion_sort.
+        constexpr std::ptrdiff_t string_insertion_threshold = 16;
+
+        // Ranges of at least this many strings are split by an MSD radix step on one byte;
+        // smaller ones by a multikey quicksort step.
+        constexpr std::ptrdiff_t string_radix_threshold = 1 << 10;
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // load_word
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        inline std::uint64_t load_word(const string_entry &entry, std::size_t depth)
+        {
+            const unsigned char *p{entry.data + depth};
+            std::size_t available{entry.size - depth};
+            if (available >= 8)
+            {
+                // Compilers turn this into one load and a byte swap.
+                return std::uint64_t{p[0]} << 56 | std::uint64_t{p[1]} << 48 | std::uint64_t{p[2]} << 40 |
+                       std::uint64_t{p[3]} << 32 | std::uint64_t{p[4]} << 24 | std::uint64_t{p[5]} << 16 |
+                       std::uint64_t{p[6]} << 8 | std::uint64_t{p[7]};
+            }
+            std::uint64_t word{0};
+            for (std::size_t k = 0; k < available; ++k)
+            {
+                word |= std::uint64_t{p[k]} << (56 - 8 * k);
+            }
+            return word;
+        }
+
+        // Bytes of word that belong to the string; 8 means the string goes on past it.
+        inline std::size_t word_clip(const string_entry &entry, std::size_t depth)
+        {
+            return std::min<std::size_t>(entry.size - depth, 8);
+        }
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // string_key_less
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Orders entries by their 8 bytes at depth only; strings equal here continue at depth + 8.
+        class string_key_less
+        {
+        public:
+            explicit string_key_less(std::size_t depth)
+                : depth_(depth)
+            {
+            }
+
+            bool operator()(const string_entry &a, const string_entry &b) const
+            {
+                return a.word < b.word || (a.word == b.word && word_clip(a, depth_) < word_clip(b, depth_));
+            }
+
+        private:
+            std::size_t depth_;
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // string_entry_less
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Orders entries completely, starting at depth.
+        class string_entry_less
+        {
+        public:
+            explicit string_entry_less(std::size_t depth)
+                : depth_(depth)
+            {
+            }
+
+            bool operator()(const string_entry &a, const string_entry &b) const
+            {
+                if (a.word != b.word)
+                {
+                    return a.word < b.word;
+                }
+                std::size_t clipA{word_clip(a, depth_)};
+                std::size_t clipB{word_clip(b, depth_)};
+                if (clipA < 8 || clipB < 8)
+                {
+                    return clipA < clipB;
+                }
+                std::size_t offset{depth_ + 8};
+                std::size_t restA{a.size - offset};
+                std::size_t restB{b.size - offset};
+                std::size_t common{std::min(restA, restB)};
+                int result{common == 0 ? 0 : std::memcmp(a.data + offset, b.data + offset, common)};
+                return result != 0 ? result < 0 : restA < restB;
+            }
+
+        private:
+            std::size_t depth_;
+        };
+
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // string_sort_entries
+        //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+        // Every range on the stack holds strings that share their first depth bytes.
+        //   - Short ranges go to insertion_sort.
+        //   - Large ranges skip the bytes all their words share and distribute on the first
+        //     byte that differs, American flag style; strings that end there are finished.
+        //   - The rest take a multikey quicksort step: a three-way partition on the cached words
+        //     whose middle part moves on to the next 8 bytes.
+        // Words are reloaded only when a range moves on, so each byte of each string is read
+        // about once.
+        inline void string_sort_entries(string_entry *first, string_entry *last)
+        {
+            struct range
+            {
+                string_entry *first;
+                string_entry *last;
+                std::size_t depth;
+            };
+
+            auto advance = [](string_entry *rangeFirst, string_entry *rangeLast, std::size_t depth) {
+                for (string_entry *entry = rangeFirst; entry != rangeLast; ++entry)
+                {
+                    entry->word = load_word(*entry, depth);
+                }
+            };
+
+            std::vector<range> pending;
+            pending.push_back(range{first, last, 0});
+            while (!pending.empty())
+            {
+                range current{pending.back()};
+                pending.pop_back();
+                std::ptrdiff_t n{current.last - current.first};
+                std::size_t depth{current.depth};
+                if (n <= string_insertion_threshold)
+                {
+                    insertion_sort(current.first, current.last, string_entry_less{depth});
+                }
+                else if (n >= string_radix_threshold)
+                {
+                    std::uint64_t lowest{~std::uint64_t{0}};
+                    std::uint64_t highest{0};
+                    std::size_t shortest{8};
+                    for (string_entry *entry = current.first; entry != current.last; ++entry)
+                    {
+                        lowest = std::min(lowest, entry->word);
+                        highest = std::max(highest, entry->word);
+                        shortest = std::min(shortest, word_clip(*entry, depth));
+                    }
+                    std::size_t position{0};
+                    while (position < shortest && ((lowest ^ highest) >> (56 - 8 * position) & 0xff) == 0)
+                    {
+                        ++position;
+                    }
+                    if (position == 8)
+                    {
+                        // Every string goes on past the same 8 bytes, as behind a shared prefix
+                        // such as a URL scheme and host: find where the first of them differs in
+                        // one pass instead of moving on 8 bytes at a time.
+                        const unsigned char *reference{current.first->data};
+                        std::size_t common{current.first->size};
+                        for (string_entry *entry = current.first; entry != current.last; ++entry)
+                        {
+                            std::size_t k{depth + 8};
+                            std::size_t limit{std::min(common, entry->size)};
+                            for (; k + 8 <= limit; k += 8)
+                            {
+                                std::uint64_t a;
+                                std::uint64_t b;
+                                std::memcpy(&a, entry->data + k, 8);
+                                std::memcpy(&b, reference + k, 8);
+                                if (a != b)
+                                {
+                                    break;
+                                }
+                            }
+                            while (k < limit && entry->data[k] == reference[k])
+                            {
+                                ++k;
+                            }
+                            common = k;
+                        }
+                        advance(current.first, current.last, common);
+                        pending.push_back(range{current.first, current.last, common});
+                        continue;
+                    }
+
+                    // Bucket 0 holds the strings that end at position, so they are all equal.
+                    constexpr int buckets = 257;
+                    auto bucket_of = [depth, position](const string_entry &entry) {
+                        return word_clip(entry, depth) <= position
+                                   ? 0
+                                   : 1 + static_cast<int>(entry.word >> (56 - 8 * position) & 0xff);
+                    };
+                    std::ptrdiff_t counts[buckets]{};
+                    for (string_entry *entry = current.first; entry != current.last; ++entry)
+                    {
+                        ++counts[bucket_of(*entry)];
+                    }
+                    string_entry *next[buckets];
+                    string_entry *ends[buckets];
+                    string_entry *cursor{current.first};
+                    for (int b = 0; b < buckets; ++b)
+                    {
+                        next[b] = cursor;
+                        cursor += counts[b];
+                        ends[b] = cursor;
+                    }
+                    for (int b = 0; b < buckets; ++b)
+                    {
+                        while (next[b] != ends[b])
+                        {
+                            int target{bucket_of(*next[b])};
+                            if (target == b)
+                            {
+                                ++next[b];
+                            }
+                            else
+                            {
+                                std::swap(*next[b], *next[target]);
+                                ++next[target];
+                            }
+                        }
+                    }
+                    cursor = current.first + counts[0];
+                    for (int b = 1; b < buckets; ++b)
+                    {
+                        if (counts[b] > 1)
+                        {
+                            pending.push_back(range{cursor, cursor + counts[b], depth});
+                        }
+                        cursor += counts[b];
+                    }
+                }
+                else
+                {
+                    string_key_less keyLess{depth};
+                    move_pivot_to_last(current.first, current.last, keyLess);
+                    std::pair<string_entry *, string_entry *> equal{
+                        partition_three_way(current.first, current.last, keyLess)};
+                    pending.push_back(range{current.first, equal.first, depth});
+                    pending.push_back(range{equal.second, current.last, depth});
+                    // The middle part is finished unless its strings go on past these 8 bytes.
+                    if (equal.second - equal.first > 1 && word_clip(*equal.first, depth) == 8)
+                    {
+                        advance(equal.first, equal.second, depth + 8);
+                        pending.push_back(range{equal.first, equal.second, depth + 8});
+                    }
+                }
+            }
+        }
+    } // namespace detail
+
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // string_sort<RandomAccessIterator>
+    //---+---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Sorts std::string, std::string_view or C strings in lexicographic order of their bytes,
+    // compared as unsigned char like std::string does. C strings are ordered by their contents,
+    // not by address. Sorts (prefix, index) entries and then moves the elements into that order.
+    template <typename RandomAccessIterator>
+    void string_sort(RandomAccessIterator first, RandomAccessIterator last)
+    {
+        using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        static_assert(detail::is_string_sortable<T>::value,
+                      "string_sort requires std::string, std::string_view or C strings");
+        std::size_t n{static_cast<std::size_t>(last - first)};
+        if (n < 2)
+        {
+            return;
+        }
+        auto less = [](const T &a, const T &b) { return detail::string_bytes(a) < detail::string_bytes(b); };
+        if (static_cast<std::ptrdiff_t>(n) <= detail::string_insertion_threshold)
+        {
+            insertion_sort(first, last, less);
+            return;
+        }
+        // Building the entries costs the same on presorted input, which a comparison sort
+        // finishes in one linear pass.
+        if (std::is_sorted(first, last, less))
+        {
+            return;
+        }
+        if (std::is_sorted(first, last, [&less](const T &a, const T &b) { return less(b, a); }))
+        {
+            std::reverse(first, last);
+            return;
+        }
+
+        std::vector<detail::string_entry> entries;
+        entries.reserve(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            std::string_view bytes{detail::string_bytes(first[i])};
+            detail::string_entry entry{0, reinterpret_cast<const unsigned char *>(bytes.data()), bytes.size(), i};
+            entry.word = detail::load_word(entry, 0);
+            entries.push_back(entry);
+        }
+        detail::string_sort_entries(entries.data(), entries.data() + n);
+        // Gathering into a buffer reads the elements in a random order once and writes them in
+        // order, where following the permutation's cycles in place would read and write at random.
+        std::vector<T> sorted;
+        sorted.reserve(n);
+        for (const detail::string_entry &entry : entries)
+        {
+            sorted.push_back(std::move(first[entry.index]));
+        }
+        entries.clear();
+        entries.shrink_to_fit();
+        std::move(sorted.begin(), sorted.end(), first);
+    }
+} // namespace omoteura
@@ -0,0 +1,216 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// stress.cpp
+// Copyright (c) 2025 ozk
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <omoteura/intro_sort.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+namespace ou = omoteura;
+
+namespace
+{
+    // Worker threads in the services that sort with this library run with stacks this small.
+    constexpr std::size_t stackSize = 256 * 1024;
+
+    // quick_sort has no depth limit, so on the median-of-3 killer it is only run up to here.
+    constexpr int quadraticLimit = 100000;
+
+    struct job
+    {
+        std::function<void()> body;
+        std::exception_ptr error;
+    };
+
+#if defined(_WIN32)
+    DWORD WINAPI run_job(LPVOID parameter)
+#else
+    void *run_job(void *parameter)
+#endif
+    {
+        job *current{static_cast<job *>(parameter)};
+        try
+        {
+            current->body();
+        }
+        catch (...)
+        {
+            current->error = std::current_exception();
+        }
+        return 0;
+    }
+
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // run_on_small_stack
+    //---------+---------+---------+---------+---------+---------+---------+---------+---------+
+    // Runs body on a new thread with a stackSize stack and waits for it.
+    void run_on_small_stack(std::function<void()> body)
+    {
+        job current{std::move(body), nullptr};
+#if defined(_WIN32)
+        HANDLE thread{CreateThread(nullptr, stackSize, run_job, &current, STACK_SIZE_PARAM_IS_A_RESERVATION, nullptr)};
+        if (thread == nullptr)
+        {
+            throw std::runtime_error("CreateThread failed");
+        }
+        WaitForSingleObject(thread, INFINITE);
+        CloseHandle(thread);
+#else
+        pthread_attr_t attributes;
+        pthread_attr_init(&attributes);
+        pthread_attr_setstacksize(&attributes, stackSize);
+        pthread_t thread;
+        int error{pthread_create(&thread, &attributes, run_job, &current)};
+        pthread_attr_destroy(&attributes);
+        if (error != 0)
+        {
+            throw std::runtime_error("pthread_create failed");
+        }
+        pthread_join(thread, nullptr);
+#endif
+        if (current.error)
+        {
+            std::rethrow_exception(current.error);
+        }
+    }
+
+    template <typename Sort>
+    bool stress(const std::string &name, const std::vector<int> &inputItems, Sort sort)
+    {
+        std::vector<int> items{inputItems};
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        run_on_small_stack([&items, sort] { sort(items); });
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (std::is_sorted(items.begin(), items.end()))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << name << " succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+            return true;
+        }
+        std::clog << name << " failed." << std::endl;
+        return false;
+    }
+
+    bool stress_all(const std::vector<int> &items, bool quadraticForQuickSort = false)
+    {
+        bool passed{true};
+        // A lambda keeps intro_sort on the comparison path instead of radix sort.
+        passed &= stress("ou::intro_sort", items, [](std::vector<int> &v) { ou::intro_sort(v.begin(), v.end()); });
+        passed &= stress("ou::intro_sort (comparator)", items, [](std::vector<int> &v) {
+            ou::intro_sort(v.begin(), v.end(), [](int a, int b) { return a < b; });
+        });
+        if (quadraticForQuickSort && items.size() > quadraticLimit)
+        {
+            std::clog << "ou::quick_sort skipped." << std::endl;
+        }
+        else
+        {
+            passed &= stress("ou::quick_sort", items, [](std::vector<int> &v) { ou::quick_sort(v.begin(), v.end()); });
+        }
+        return passed;
+    }
+
+    std::vector<int> organ_pipe(int n)
+    {
+        std::vector<int> items(n);
+        for (int i = 0; i < n; ++i)
+        {
+            items[i] = i < n / 2 ? i : n - 1 - i;
+        }
+        return items;
+    }
+
+    // David R. Musser, "Introspective Sorting and Selection Algorithms" (1997)
+    std::vector<int> median_of_3_killer(int n)
+    {
+        std::vector<int> items(n);
+        int k = n / 2;
+        for (int i = 1; i <= k; ++i)
+        {
+            if (i % 2 == 1)
+            {
+                items[i - 1] = i;
+                // With k odd, slot k belongs to the second half.
+                if (i < k)
+                {
+                    items[i] = k + i;
+                }
+            }
+            items[k + i - 1] = 2 * i;
+        }
+        if (n % 2 == 1)
+        {
+            items[n - 1] = n;
+        }
+        return items;
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        int n = 100000000;
+        if (argc > 1)
+        {
+            n = std::stoi(argv[1]);
+        }
+        if (n < 0)
+        {
+            std::cerr << "Usage: stress [number of items]" << std::endl;
+            return 1;
+        }
+
+        std::clog << "Sorting on a thread with a " << stackSize / 1024 << " KiB stack." << std::endl;
+        bool passed{true};
+        {
+            std::clog << n << " items sorted in descending order:" << std::endl;
+            std::vector<int> items(n);
+            for (int i = 0; i < n; ++i)
+            {
+                items[i] = n - i;
+            }
+            passed &= stress_all(items);
+        }
+        {
+            std::clog << n << " items arranged in organ-pipe order:" << std::endl;
+            passed &= stress_all(organ_pipe(n));
+        }
+        {
+            std::clog << n << " items arranged as median-of-3 killer:" << std::endl;
+            passed &= stress_all(median_of_3_killer(n), true);
+        }
+        {
+            int m = std::min(n, quadraticLimit);
+            std::clog << m << " items arranged as median-of-3 killer:" << std::endl;
+            passed &= stress("ou::quick_sort", median_of_3_killer(m), [](std::vector<int> &v) {
+                ou::quick_sort(v.begin(), v.end());
+            });
+        }
+        if (!passed)
+        {
+            return 1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "An exception occurred: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
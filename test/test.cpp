@@ -4,85 +4,1081 @@
 // SPDX-License-Identifier: MIT
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 #include <algorithm>
+#include <array>
 #include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
 #include <iostream>
 #include <limits>
+#include <omoteura/external_sort.h>
 #include <omoteura/intro_sort.h>
+#include <omoteura/parallel_intro_sort.h>
+#include <omoteura/parallel_merge_sort.h>
+#include <omoteura/selection.h>
+#include <omoteura/sort_batch.h>
+#include <omoteura/sort_stream.h>
+#include <omoteura/sort_unique.h>
+#include <omoteura/sort_zip.h>
+#include <omoteura/static_sort.h>
+#include <omoteura/stable_sort.h>
+#include <omoteura/string_sort.h>
 #include <random>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace ou = omoteura;
 
-void test(const std::vector<int> &inputItems)
+// Whether a and b hold the same bit patterns, so that -0.0 and 0.0 count as different values.
+template <typename T>
+bool isBitwisePermutation(const T *a, const T *b, std::size_t n)
+{
+    static_assert(sizeof(T) <= sizeof(std::uint64_t), "T should fit in 64 bits");
+    std::vector<std::uint64_t> aBits(n);
+    std::vector<std::uint64_t> bBits(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        std::memcpy(&aBits[i], &a[i], sizeof(T));
+        std::memcpy(&bBits[i], &b[i], sizeof(T));
+    }
+    std::sort(aBits.begin(), aBits.end());
+    std::sort(bBits.begin(), bBits.end());
+    return aBits == bBits;
+}
+
+// Sorts the first N of values with the bitonic kernel of one instruction set.
+template <typename T, int N, typename Compare>
+bool blockSorts(const std::vector<T> &values, Compare comp, ou::detail::simd_level level)
+{
+#if defined(OMOTEURA_INTROSORT_SIMD_X86)
+    constexpr bool descending{std::is_same<Compare, std::greater<T>>::value};
+    alignas(32) T data[N];
+    std::copy(values.begin(), values.begin() + N, data);
+    ou::detail::bitonic_sort_block<T, N, descending>(data, level);
+    return std::is_sorted(data, data + N, comp) && isBitwisePermutation(data, values.data(), N);
+#else
+    static_cast<void>(values);
+    static_cast<void>(comp);
+    static_cast<void>(level);
+    return true;
+#endif
+}
+
+// Sorts every prefix of values with ou::detail::network_sort, which pads each to 8, 16, 32 or 64
+// lanes, and up to 128 or 256 lanes with the wide networks of sort_batch, and the whole of them
+// with the kernels of every instruction set the CPU has.
+template <typename T, typename Compare>
+bool networkSorts(const std::vector<T> &values, Compare comp)
+{
+    bool sorted{true};
+    for (std::size_t n = 0; n <= values.size(); ++n)
+    {
+        std::vector<T> items(values.begin(), values.begin() + n);
+        if (ou::detail::network_sort(items.begin(), items.end(), comp))
+        {
+            sorted = sorted && std::is_sorted(items.begin(), items.end(), comp) &&
+                     isBitwisePermutation(items.data(), values.data(), n);
+        }
+        std::vector<T> wideItems(values.begin(), values.begin() + n);
+        if (ou::detail::network_sort<ou::detail::wide_network_max_size>(wideItems.begin(), wideItems.end(), comp))
+        {
+            sorted = sorted && std::is_sorted(wideItems.begin(), wideItems.end(), comp) &&
+                     isBitwisePermutation(wideItems.data(), values.data(), n);
+        }
+    }
+    for (ou::detail::simd_level level :
+         {ou::detail::simd_level::sse42, ou::detail::simd_level::avx2, ou::detail::simd_level::avx512})
+    {
+        if (level <= ou::detail::current_simd_level() && values.size() >= ou::detail::network_max_size)
+        {
+            sorted = sorted && blockSorts<T, 8>(values, comp, level) && blockSorts<T, 16>(values, comp, level) &&
+                     blockSorts<T, 32>(values, comp, level) && blockSorts<T, 64>(values, comp, level);
+        }
+        if (level >= ou::detail::simd_level::avx2 && level <= ou::detail::current_simd_level() &&
+            values.size() >= ou::detail::wide_network_max_size)
+        {
+            sorted = sorted && blockSorts<T, 128>(values, comp, level) && blockSorts<T, 256>(values, comp, level);
+        }
+    }
+    return sorted;
+}
+
+// Partitions prefixes of values around several pivots with ou::detail::simd_partition, using the
+// AVX2 and the AVX-512 kernels where the CPU has them.
+template <typename T, typename Compare>
+bool simdPartitions(const std::vector<T> &values, Compare comp)
+{
+    constexpr bool descending{std::is_same<Compare, std::greater<T>>::value};
+    std::vector<T> pivots{*std::min_element(values.begin(), values.end()), values[values.size() / 2],
+                          *std::max_element(values.begin(), values.end()), T{}};
+    bool partitioned{true};
+    for (ou::detail::simd_level level : {ou::detail::simd_level::avx2, ou::detail::simd_level::avx512})
+    {
+        if (level > ou::detail::current_simd_level())
+        {
+            continue;
+        }
+        for (std::size_t n = ou::detail::simd_partition_min_size; n <= values.size(); n += n / 2 + 13)
+        {
+            for (T pivot : pivots)
+            {
+                std::vector<T> items(values.begin(), values.begin() + n);
+                T *middle{ou::detail::simd_partition<descending>(items.data(), items.data() + n, pivot, level)};
+                partitioned = partitioned && middle != nullptr &&
+                              std::none_of(items.data(), middle, [&](T item) { return comp(pivot, item); }) &&
+                              std::none_of(middle, items.data() + n, [&](T item) { return comp(item, pivot); }) &&
+                              isBitwisePermutation(items.data(), values.data(), n);
+            }
+        }
+    }
+    return partitioned;
+}
+
+// Sorts values with ou::radix_sort and ou::radix_sort_in_place and compares both with std::sort,
+// which checks that the keys the digits are taken from order the values as comp does.
+template <typename T, typename Compare>
+bool radixSortsLikeStdSort(const std::vector<T> &values, Compare comp)
+{
+    std::vector<T> expected{values};
+    std::sort(expected.begin(), expected.end(), comp);
+    std::vector<T> buffered{values};
+    ou::radix_sort(buffered.begin(), buffered.end(), comp);
+    std::vector<T> inPlace{values};
+    ou::radix_sort_in_place(inPlace.begin(), inPlace.end(), comp);
+    return buffered == expected && inPlace == expected &&
+           isBitwisePermutation(buffered.data(), values.data(), values.size()) &&
+           isBitwisePermutation(inPlace.data(), values.data(), values.size());
+}
+
+void test(const std::vector<int> &inputItems, bool quadraticForQuickSort = false)
 {
     // ou::insertion_sort
     if (inputItems.size() > 100000)
     {
         std::clog << "ou::insertion_sort skipped." << std::endl;
     }
-    else
+    else
+    {
+        std::vector<int> items{inputItems};
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        ou::insertion_sort(items.begin(), items.end());
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (std::is_sorted(items.begin(), items.end()))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::insertion_sort succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::insertion_sort failed." << std::endl;
+        }
+    }
+    // ou::heap_sort
+    {
+        std::vector<int> items{inputItems};
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        ou::heap_sort(items.begin(), items.end());
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (std::is_sorted(items.begin(), items.end()))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::heap_sort succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::heap_sort failed." << std::endl;
+        }
+    }
+    // ou::heap_sort<ou::bottom_up_heap>
+    {
+        std::vector<int> items{inputItems};
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        ou::heap_sort<ou::bottom_up_heap>(items.begin(), items.end());
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (std::is_sorted(items.begin(), items.end()))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::heap_sort<ou::bottom_up_heap> succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::heap_sort<ou::bottom_up_heap> failed." << std::endl;
+        }
+    }
+    // ou::heap_sort<ou::dary_heap<4>>
+    {
+        std::vector<int> items{inputItems};
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        ou::heap_sort<ou::dary_heap<4>>(items.begin(), items.end());
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (std::is_sorted(items.begin(), items.end()))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::heap_sort<ou::dary_heap<4>> succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::heap_sort<ou::dary_heap<4>> failed." << std::endl;
+        }
+    }
+    // ou::heap_sort<ou::dary_heap<8>>
+    {
+        std::vector<int> items{inputItems};
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        ou::heap_sort<ou::dary_heap<8>>(items.begin(), items.end());
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (std::is_sorted(items.begin(), items.end()))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::heap_sort<ou::dary_heap<8>> succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::heap_sort<ou::dary_heap<8>> failed." << std::endl;
+        }
+    }
+    // ou::quick_sort
+    if (quadraticForQuickSort && inputItems.size() > 100000)
+    {
+        std::clog << "ou::quick_sort skipped." << std::endl;
+    }
+    else
+    {
+        std::vector<int> items{inputItems};
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        ou::quick_sort(items.begin(), items.end());
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (std::is_sorted(items.begin(), items.end()))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::quick_sort succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::quick_sort failed." << std::endl;
+        }
+    }
+    // ou::intro_sort
+    {
+        std::vector<int> items{inputItems};
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        ou::intro_sort(items.begin(), items.end());
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (std::is_sorted(items.begin(), items.end()))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::intro_sort succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::intro_sort failed." << std::endl;
+        }
+    }
+    // ou::intro_sort with ou::sort_stats
+    {
+        std::vector<int> items{inputItems};
+        ou::sort_stats stats;
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        ou::intro_sort(items.begin(), items.end(), std::less<int>{}, stats);
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        // Whatever the input, including the median-of-3 killer, no range should be left to
+        // heap_sort and the comparisons should stay within a small multiple of n log2 n.
+        double size{static_cast<double>(items.size())};
+        double comparisonBound{2.0 * size * std::max(1.0, std::log2(size))};
+        if (std::is_sorted(items.begin(), items.end()) && stats.heap_fallbacks == 0 &&
+            static_cast<double>(stats.comparisons) <= comparisonBound)
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::intro_sort with ou::sort_stats succeeded. " << std::fixed << seconds << " [s]"
+                      << " comparisons: " << stats.comparisons << ", swaps: " << stats.swaps
+                      << ", moves: " << stats.moves << ", max depth: " << stats.max_depth
+                      << ", heap fallbacks: " << stats.heap_fallbacks << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::intro_sort with ou::sort_stats failed." << std::endl;
+        }
+    }
+    // ou::nth_element
+    if (!inputItems.empty())
+    {
+        std::vector<int> items{inputItems};
+        std::vector<int>::iterator nth{items.begin() + items.size() / 2};
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        ou::nth_element(items.begin(), nth, items.end());
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (std::all_of(items.begin(), nth, [&](int item) { return item <= *nth; }) &&
+            std::all_of(nth, items.end(), [&](int item) { return *nth <= item; }))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::nth_element succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::nth_element failed." << std::endl;
+        }
+    }
+    // ou::partial_sort
+    {
+        std::vector<int> items{inputItems};
+        std::vector<int>::iterator middle{items.begin() + std::min<std::size_t>(items.size(), 100)};
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        ou::partial_sort(items.begin(), middle, items.end());
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (std::is_sorted(items.begin(), middle) &&
+            (middle == items.begin() || std::all_of(middle, items.end(), [&](int item) { return *(middle - 1) <= item; })))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::partial_sort succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::partial_sort failed." << std::endl;
+        }
+    }
+    // ou::top_k
+    {
+        std::vector<int> items{inputItems};
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        std::vector<int>::iterator middle{ou::top_k(items.begin(), items.end(), 100)};
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (std::is_sorted(items.begin(), middle, std::greater<int>{}) &&
+            (middle == items.begin() || std::all_of(middle, items.end(), [&](int item) { return item <= *(middle - 1); })))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::top_k succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::top_k failed." << std::endl;
+        }
+    }
+    // ou::intro_sort_by_key
+    {
+        std::vector<int> items{inputItems};
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        ou::intro_sort_by_key(items.begin(), items.end(), [](int item) { return item; });
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (std::is_sorted(items.begin(), items.end()))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::intro_sort_by_key succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::intro_sort_by_key failed." << std::endl;
+        }
+    }
+    {
+        // Rows of a table sorted by one column: the key is a member of a larger record, and the
+        // rest of the record has to travel with it.
+        struct row
+        {
+            int key;
+            std::size_t id;
+            std::array<char, 48> payload;
+        };
+        std::vector<row> items(inputItems.size());
+        for (std::size_t i = 0; i < items.size(); ++i)
+        {
+            items[i].key = inputItems[i];
+            items[i].id = i;
+            items[i].payload.fill(static_cast<char>(i % 128));
+        }
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        ou::intro_sort_by_key(items.begin(), items.end(), &row::key);
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        std::vector<bool> seen(items.size());
+        bool intact{std::all_of(items.begin(), items.end(), [&](const row &item) {
+            bool fresh{!seen[item.id]};
+            seen[item.id] = true;
+            return fresh && item.key == inputItems[item.id] &&
+                   std::all_of(item.payload.begin(), item.payload.end(),
+                               [&](char c) { return c == static_cast<char>(item.id % 128); });
+        })};
+        if (intact && std::is_sorted(items.begin(), items.end(), [](const row &a, const row &b) { return a.key < b.key; }))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::intro_sort_by_key with a member succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::intro_sort_by_key with a member failed." << std::endl;
+        }
+    }
+    {
+        // Records keyed by a name, which the projection copies into the cached keys.
+        std::vector<std::pair<std::string, int>> items(inputItems.size());
+        for (std::size_t i = 0; i < items.size(); ++i)
+        {
+            items[i] = {"user-" + std::to_string(inputItems[i]), inputItems[i]};
+        }
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        ou::intro_sort_by_key(items.begin(), items.end(),
+                              [](const std::pair<std::string, int> &item) { return item.first; });
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        bool intact{std::all_of(items.begin(), items.end(), [](const std::pair<std::string, int> &item) {
+            return item.first == "user-" + std::to_string(item.second);
+        })};
+        std::vector<int> values(items.size());
+        std::transform(items.begin(), items.end(), values.begin(),
+                       [](const std::pair<std::string, int> &item) { return item.second; });
+        std::vector<int> expected{inputItems};
+        std::sort(values.begin(), values.end());
+        std::sort(expected.begin(), expected.end());
+        if (intact && values == expected &&
+            std::is_sorted(items.begin(), items.end(),
+                           [](const std::pair<std::string, int> &a, const std::pair<std::string, int> &b) {
+                               return a.first < b.first;
+                           }))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::intro_sort_by_key with a std::string key succeeded. " << std::fixed << seconds << " [s]"
+                      << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::intro_sort_by_key with a std::string key failed." << std::endl;
+        }
+    }
+    // ou::parallel_intro_sort
+    {
+        std::vector<int> items{inputItems};
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        ou::parallel_intro_sort(items.begin(), items.end());
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (std::is_sorted(items.begin(), items.end()))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::parallel_intro_sort succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::parallel_intro_sort failed." << std::endl;
+        }
+    }
+    // ou::parallel_merge_sort
+    {
+        std::vector<int> items{inputItems};
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        ou::parallel_merge_sort(items.begin(), items.end());
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (std::is_sorted(items.begin(), items.end()))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::parallel_merge_sort succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::parallel_merge_sort failed." << std::endl;
+        }
+    }
+    {
+        // Thread counts that do not divide the size, on the input and on a range of a few dozen
+        // keys long enough for the chunks to be merged rather than sorted by intro_sort.
+        std::vector<int> duplicates(3 * (1 << 16) + 7);
+        for (std::size_t i = 0; i < duplicates.size(); ++i)
+        {
+            duplicates[i] = static_cast<int>(i * 7919 % 61);
+        }
+        const std::vector<int> *inputs[]{&inputItems, &duplicates};
+        bool sorted{true};
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        for (unsigned threads : {2u, 3u, 8u})
+        {
+            for (const std::vector<int> *input : inputs)
+            {
+                std::vector<int> items{*input};
+                ou::parallel_merge_sort(items.begin(), items.end(), std::less<int>{}, threads);
+                std::vector<int> expected{*input};
+                std::sort(expected.begin(), expected.end());
+                sorted = sorted && items == expected;
+            }
+        }
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (sorted)
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::parallel_merge_sort with 2, 3 and 8 threads succeeded. " << std::fixed << seconds << " [s]"
+                      << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::parallel_merge_sort with 2, 3 and 8 threads failed." << std::endl;
+        }
+    }
+    // ou::stable_sort
+    {
+        std::vector<int> items{inputItems};
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        ou::stable_sort(items.begin(), items.end());
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (std::is_sorted(items.begin(), items.end()))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::stable_sort succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::stable_sort failed." << std::endl;
+        }
+    }
+    {
+        // Records with a handful of keys, like rows sorted by status. The position in the input
+        // is the value, so equal keys have to keep their values in increasing order.
+        std::vector<std::pair<int, std::size_t>> items(inputItems.size());
+        for (std::size_t i = 0; i < items.size(); ++i)
+        {
+            items[i] = {inputItems[i] % 16, i};
+        }
+        std::vector<std::pair<int, std::size_t>> buffer;
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        ou::stable_sort(
+            items.begin(), items.end(),
+            [](const std::pair<int, std::size_t> &a, const std::pair<int, std::size_t> &b) { return a.first < b.first; },
+            buffer);
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (std::is_sorted(items.begin(), items.end()))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::stable_sort with equal keys succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::stable_sort with equal keys failed." << std::endl;
+        }
+    }
+    // ou::external_sort
+    {
+        const char *inputPath{"external_sort_input.bin"};
+        const char *outputPath{"external_sort_output.bin"};
+        {
+            std::ofstream file{inputPath, std::ios::binary};
+            file.write(reinterpret_cast<const char *>(inputItems.data()),
+                       static_cast<std::streamsize>(inputItems.size() * sizeof(int)));
+        }
+        ou::external_sort_options options;
+        options.record_size = sizeof(int);
+        // Small enough to spill runs and to merge them in more than one pass.
+        options.memory_budget = 1 << 20;
+        options.block_size = 64 << 10;
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        ou::external_sort(inputPath, outputPath, options, [](const unsigned char *record) {
+            int value;
+            std::memcpy(&value, record, sizeof(int));
+            return value;
+        });
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        std::vector<int> items(inputItems.size());
+        {
+            std::ifstream file{outputPath, std::ios::binary};
+            file.read(reinterpret_cast<char *>(items.data()), static_cast<std::streamsize>(items.size() * sizeof(int)));
+        }
+        std::remove(inputPath);
+        std::remove(outputPath);
+        if (std::is_sorted(items.begin(), items.end()))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::external_sort succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::external_sort failed." << std::endl;
+        }
+    }
+    // ou::radix_sort
     {
         std::vector<int> items{inputItems};
         std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
-        ou::insertion_sort(items.begin(), items.end());
+        ou::radix_sort(items.begin(), items.end());
         std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
         if (std::is_sorted(items.begin(), items.end()))
         {
             double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
-            std::clog << "ou::insertion_sort succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+            std::clog << "ou::radix_sort succeeded. " << std::fixed << seconds << " [s]" << std::endl;
         }
         else
         {
-            std::clog << "ou::insertion_sort failed." << std::endl;
+            std::clog << "ou::radix_sort failed." << std::endl;
         }
     }
-    // ou::heap_sort
+    // ou::radix_sort_in_place
     {
         std::vector<int> items{inputItems};
         std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
-        ou::heap_sort(items.begin(), items.end());
+        ou::radix_sort_in_place(items.begin(), items.end());
         std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
         if (std::is_sorted(items.begin(), items.end()))
         {
             double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
-            std::clog << "ou::heap_sort succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+            std::clog << "ou::radix_sort_in_place succeeded. " << std::fixed << seconds << " [s]" << std::endl;
         }
         else
         {
-            std::clog << "ou::heap_sort failed." << std::endl;
+            std::clog << "ou::radix_sort_in_place failed." << std::endl;
         }
     }
-    // ou::quick_sort
     {
+        // Keys on both sides of zero for every transform to an unsigned digit, in both orders.
+        // Floating-point keys also hold signed zeros and infinities.
+        std::vector<std::int32_t> int32s(inputItems.size());
+        std::vector<std::int64_t> int64s(inputItems.size());
+        std::vector<float> floats(inputItems.size());
+        std::vector<double> doubles(inputItems.size());
+        for (std::size_t i = 0; i < inputItems.size(); ++i)
+        {
+            std::int32_t key{inputItems[i] - static_cast<std::int32_t>(inputItems.size() / 2)};
+            int32s[i] = key;
+            int64s[i] = std::int64_t{key} * (std::int64_t{1} << 33) + static_cast<std::int64_t>(i % 3);
+            floats[i] = i % 11 == 0 ? -0.0f : static_cast<float>(key) / 7.0f;
+            doubles[i] = i % 11 == 0 ? -0.0 : static_cast<double>(key) / 7.0;
+        }
+        for (std::size_t i = 1; i < inputItems.size(); i += 97)
+        {
+            floats[i] = i % 2 == 0 ? std::numeric_limits<float>::infinity() : -std::numeric_limits<float>::infinity();
+            doubles[i] = i % 2 == 0 ? std::numeric_limits<double>::infinity() : -std::numeric_limits<double>::infinity();
+        }
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        bool sorted{radixSortsLikeStdSort(int32s, std::less<std::int32_t>{}) &&
+                    radixSortsLikeStdSort(int32s, std::greater<std::int32_t>{}) &&
+                    radixSortsLikeStdSort(int64s, std::less<std::int64_t>{}) &&
+                    radixSortsLikeStdSort(int64s, std::greater<std::int64_t>{}) &&
+                    radixSortsLikeStdSort(floats, std::less<float>{}) &&
+                    radixSortsLikeStdSort(floats, std::greater<float>{}) &&
+                    radixSortsLikeStdSort(doubles, std::less<double>{}) &&
+                    radixSortsLikeStdSort(doubles, std::greater<double>{})};
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (sorted)
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::radix_sort with signed and floating-point keys succeeded. " << std::fixed << seconds << " [s]"
+                      << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::radix_sort with signed and floating-point keys failed." << std::endl;
+        }
+    }
+    // ou::sort_batch
+    {
+        // Segments of 8 to 200 items, like per-row candidate lists.
+        std::vector<std::size_t> offsets{0};
+        for (std::size_t i = 0; offsets.back() < inputItems.size(); ++i)
+        {
+            offsets.push_back(std::min(inputItems.size(), offsets.back() + 8 + i * 37 % 193));
+        }
+        auto segmentsSorted = [&offsets](const std::vector<int> &items) {
+            for (std::size_t s = 0; s + 1 < offsets.size(); ++s)
+            {
+                if (!std::is_sorted(items.begin() + offsets[s], items.begin() + offsets[s + 1]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        };
+        // Each segment by itself, the loop sort_batch replaces.
+        std::vector<int> loopItems{inputItems};
+        std::chrono::steady_clock::time_point loopStart{std::chrono::steady_clock::now()};
+        for (std::size_t s = 0; s + 1 < offsets.size(); ++s)
+        {
+            ou::intro_sort(loopItems.begin() + offsets[s], loopItems.begin() + offsets[s + 1]);
+        }
+        std::chrono::steady_clock::time_point loopEnd{std::chrono::steady_clock::now()};
+        double loopSeconds =
+            std::chrono::duration_cast<std::chrono::microseconds>(loopEnd - loopStart).count() / 1000000.0;
+        if (segmentsSorted(loopItems))
+        {
+            std::clog << "ou::intro_sort per segment succeeded. " << std::fixed << loopSeconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::intro_sort per segment failed." << std::endl;
+        }
         std::vector<int> items{inputItems};
         std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
-        ou::quick_sort(items.begin(), items.end());
+        ou::sort_batch(items.begin(), offsets.begin(), offsets.end());
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+        // Slower than the loop means the segment kernels are not being used. Sorted segments take
+        // the same single pass either way, so a quarter is left for timer noise, and below a
+        // millisecond the timings are too coarse to compare.
+        if (segmentsSorted(items) && (seconds <= loopSeconds * 1.25 || loopSeconds < 0.001))
+        {
+            std::clog << "ou::sort_batch succeeded. " << std::fixed << seconds << " [s] ("
+                      << (seconds > 0.0 ? loopSeconds / seconds : 0.0) << " times as fast as per segment)" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::sort_batch failed." << std::endl;
+        }
+    }
+    // ou::sort_stream
+    {
+        // Batches of 1000 items, as a decoder hands them over, in chunks small enough that
+        // inputs of this size are merged from many.
+        ou::sort_stream_options options;
+        options.chunk_size = 1 << 14;
+        options.threads = 2;
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        ou::sort_stream<int> stream{std::less<int>{}, options};
+        for (std::size_t i = 0; i < inputItems.size(); i += 1000)
+        {
+            stream.push(inputItems.begin() + i, inputItems.begin() + std::min(inputItems.size(), i + 1000));
+        }
+        std::vector<int> items;
+        items.reserve(inputItems.size());
+        // Both increments, alternately.
+        for (ou::sort_stream<int>::iterator i{stream.begin()}; i != stream.end();)
+        {
+            if (items.size() % 2 == 0)
+            {
+                items.push_back(*i++);
+            }
+            else
+            {
+                items.push_back(*i);
+                ++i;
+            }
+        }
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        // Against the sorted input, std::is_permutation stops after one pass over the common
+        // prefix when the output is right.
+        std::vector<int> sortedInput{inputItems};
+        std::sort(sortedInput.begin(), sortedInput.end());
+        if (items.size() == inputItems.size() && std::is_sorted(items.begin(), items.end()) &&
+            std::is_permutation(items.begin(), items.end(), sortedInput.begin()))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::sort_stream succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::sort_stream failed." << std::endl;
+        }
+    }
+    // ou::sort_unique, ou::sort_reduce_by_key
+    {
+        std::vector<int> distinctItems{inputItems};
+        std::sort(distinctItems.begin(), distinctItems.end());
+        distinctItems.erase(std::unique(distinctItems.begin(), distinctItems.end()), distinctItems.end());
+        {
+            std::vector<int> items{inputItems};
+            std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+            items.erase(ou::sort_unique(items.begin(), items.end()), items.end());
+            std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+            if (items == distinctItems)
+            {
+                double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+                std::clog << "ou::sort_unique succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+            }
+            else
+            {
+                std::clog << "ou::sort_unique failed." << std::endl;
+            }
+        }
+        {
+            // Counts the occurrences of every item, so the counts add up to the input size.
+            std::vector<std::pair<int, std::size_t>> counts;
+            counts.reserve(inputItems.size());
+            for (int item : inputItems)
+            {
+                counts.emplace_back(item, 1);
+            }
+            std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+            counts.erase(ou::sort_reduce_by_key(
+                             counts.begin(),
+                             counts.end(),
+                             [](const std::pair<int, std::size_t> &count) { return count.first; },
+                             [](std::pair<int, std::size_t> &kept, std::pair<int, std::size_t> &&other) {
+                                 kept.second += other.second;
+                             }),
+                         counts.end());
+            std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+            bool succeeded{counts.size() == distinctItems.size()};
+            std::size_t total{0};
+            for (std::size_t i = 0; succeeded && i < counts.size(); ++i)
+            {
+                succeeded = counts[i].first == distinctItems[i];
+                total += counts[i].second;
+            }
+            if (succeeded && total == inputItems.size())
+            {
+                double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+                std::clog << "ou::sort_reduce_by_key succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+            }
+            else
+            {
+                std::clog << "ou::sort_reduce_by_key failed." << std::endl;
+            }
+        }
+    }
+    // ou::sort_zip, ou::argsort
+    {
+        // A key column with two payload columns, as in columnar storage. Each row's payload is
+        // its original position, so a payload that did not move with its key is caught.
+        auto rowsIntact = [&inputItems](const std::vector<int> &keys,
+                                         const std::vector<std::size_t> &rows,
+                                         const std::vector<double> &values) {
+            if (!std::is_sorted(keys.begin(), keys.end()))
+            {
+                return false;
+            }
+            for (std::size_t i = 0; i < keys.size(); ++i)
+            {
+                if (rows[i] >= inputItems.size() || inputItems[rows[i]] != keys[i] ||
+                    values[i] != static_cast<double>(rows[i]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        };
+        std::vector<std::size_t> inputRows(inputItems.size());
+        std::vector<double> inputValues(inputItems.size());
+        for (std::size_t i = 0; i < inputItems.size(); ++i)
+        {
+            inputRows[i] = i;
+            inputValues[i] = static_cast<double>(i);
+        }
+        {
+            std::vector<int> keys{inputItems};
+            std::vector<std::size_t> rows{inputRows};
+            std::vector<double> values{inputValues};
+            std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+            ou::sort_zip(keys.begin(), keys.end(), rows.begin(), values.begin());
+            std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+            if (rowsIntact(keys, rows, values))
+            {
+                double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+                std::clog << "ou::sort_zip succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+            }
+            else
+            {
+                std::clog << "ou::sort_zip failed." << std::endl;
+            }
+        }
+        {
+            std::vector<int> keys{inputItems};
+            std::vector<std::size_t> rows{inputRows};
+            std::vector<double> values{inputValues};
+            std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+            std::vector<std::size_t> order{ou::argsort(keys.begin(), keys.end())};
+            std::vector<int> sortedKeys(keys.size());
+            std::vector<std::size_t> sortedRows(rows.size());
+            std::vector<double> sortedValues(values.size());
+            for (std::size_t i = 0; i < order.size(); ++i)
+            {
+                sortedKeys[i] = keys[order[i]];
+                sortedRows[i] = rows[order[i]];
+                sortedValues[i] = values[order[i]];
+            }
+            std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+            if (rowsIntact(sortedKeys, sortedRows, sortedValues))
+            {
+                double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+                std::clog << "ou::argsort and gather succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+            }
+            else
+            {
+                std::clog << "ou::argsort and gather failed." << std::endl;
+            }
+        }
+        {
+            struct row
+            {
+                int key;
+                std::size_t row;
+                double value;
+            };
+            std::vector<int> keys{inputItems};
+            std::vector<std::size_t> rows{inputRows};
+            std::vector<double> values{inputValues};
+            std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+            std::vector<row> packed(keys.size());
+            for (std::size_t i = 0; i < keys.size(); ++i)
+            {
+                packed[i] = row{keys[i], rows[i], values[i]};
+            }
+            ou::intro_sort(packed.begin(), packed.end(), [](const row &a, const row &b) { return a.key < b.key; });
+            for (std::size_t i = 0; i < packed.size(); ++i)
+            {
+                keys[i] = packed[i].key;
+                rows[i] = packed[i].row;
+                values[i] = packed[i].value;
+            }
+            std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+            if (rowsIntact(keys, rows, values))
+            {
+                double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+                std::clog << "ou::intro_sort packed and unpacked succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+            }
+            else
+            {
+                std::clog << "ou::intro_sort packed and unpacked failed." << std::endl;
+            }
+        }
+    }
+    // ou::string_sort
+    {
+        // Keys behind a shared prefix, like URLs or paths.
+        std::vector<std::string> items;
+        items.reserve(inputItems.size());
+        for (int item : inputItems)
+        {
+            items.push_back("https://www.example.com/items/" + std::to_string(item));
+        }
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        ou::string_sort(items.begin(), items.end());
         std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
         if (std::is_sorted(items.begin(), items.end()))
         {
             double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
-            std::clog << "ou::quick_sort succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+            std::clog << "ou::string_sort succeeded. " << std::fixed << seconds << " [s]" << std::endl;
         }
         else
         {
-            std::clog << "ou::quick_sort failed." << std::endl;
+            std::clog << "ou::string_sort failed." << std::endl;
         }
     }
-    // ou::intro_sort
+    // ou::static_sort
     {
+        // Windows of 5 items, like a median filter, and of 16, like k-NN candidate sets.
+        constexpr std::array<int, 5> median{[] {
+            std::array<int, 5> window{5, 1, 4, 2, 3};
+            ou::static_sort(window);
+            return window;
+        }()};
+        static_assert(median[2] == 3, "ou::static_sort should run in constant expressions");
         std::vector<int> items{inputItems};
+        std::size_t fives{items.size() / 5 * 5};
+        std::size_t sixteens{items.size() / 16 * 16};
         std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
-        ou::intro_sort(items.begin(), items.end());
+        for (std::size_t i = 0; i < fives; i += 5)
+        {
+            ou::static_sort<5>(items.begin() + i);
+        }
         std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
-        if (std::is_sorted(items.begin(), items.end()))
+        bool sorted{true};
+        for (std::size_t i = 0; i < fives; i += 5)
+        {
+            sorted = sorted && std::is_sorted(items.begin() + i, items.begin() + i + 5);
+        }
+        items = inputItems;
+        std::array<int, 16> candidates{};
+        for (std::size_t i = 0; i < sixteens; i += 16)
+        {
+            std::copy(items.begin() + i, items.begin() + i + 16, candidates.begin());
+            ou::static_sort(candidates, std::greater<int>{});
+            sorted = sorted && std::is_sorted(candidates.rbegin(), candidates.rend()) &&
+                     std::is_permutation(candidates.begin(), candidates.end(), items.begin() + i);
+        }
+        if (sorted)
         {
             double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
-            std::clog << "ou::intro_sort succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+            std::clog << "ou::static_sort succeeded. " << std::fixed << seconds << " [s]" << std::endl;
         }
         else
         {
-            std::clog << "ou::intro_sort failed." << std::endl;
+            std::clog << "ou::static_sort failed." << std::endl;
+        }
+    }
+    // ou::detail::network_sort
+    {
+        // The leaves of intro_sort and the segments of sort_batch for every type and order the
+        // SIMD networks handle, with negatives, duplicates, signed zeros and infinities among the
+        // keys.
+        constexpr std::size_t lanes{ou::detail::wide_network_max_size};
+        std::vector<int> keys(lanes);
+        for (std::size_t i = 0; i < lanes; ++i)
+        {
+            keys[i] = (i < inputItems.size() ? inputItems[i] : static_cast<int>(i * 7)) % 48 - 24;
+        }
+        std::vector<std::uint32_t> uint32s(keys.begin(), keys.end());
+        std::vector<std::int64_t> int64s(keys.begin(), keys.end());
+        std::vector<float> floats(keys.begin(), keys.end());
+        std::vector<double> doubles(keys.begin(), keys.end());
+        for (std::size_t i : {std::size_t{1}, std::size_t{7}, std::size_t{20}, std::size_t{41}})
+        {
+            floats[i] = -0.0f;
+            doubles[i] = -0.0;
+        }
+        floats[3] = std::numeric_limits<float>::infinity();
+        floats[30] = -std::numeric_limits<float>::infinity();
+        doubles[3] = std::numeric_limits<double>::infinity();
+        doubles[30] = -std::numeric_limits<double>::infinity();
+        for (std::int64_t &item : int64s)
+        {
+            item *= std::int64_t{1} << 40;
+        }
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        bool sorted{networkSorts(keys, std::less<int>{}) && networkSorts(keys, std::greater<int>{}) &&
+                    networkSorts(uint32s, std::less<std::uint32_t>{}) &&
+                    networkSorts(uint32s, std::greater<std::uint32_t>{}) &&
+                    networkSorts(int64s, std::less<std::int64_t>{}) &&
+                    networkSorts(int64s, std::greater<std::int64_t>{}) && networkSorts(floats, std::less<float>{}) &&
+                    networkSorts(floats, std::greater<float>{}) && networkSorts(doubles, std::less<double>{}) &&
+                    networkSorts(doubles, std::greater<double>{})};
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (sorted)
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::detail::network_sort succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::detail::network_sort failed." << std::endl;
+        }
+    }
+    // ou::detail::simd_partition
+    {
+        // The partition step of intro_sort for every type and order the SIMD kernels handle, with
+        // negatives, many keys equal to the pivot, signed zeros and infinities.
+        constexpr std::size_t size{1000};
+        std::vector<int> keys(size);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            keys[i] = (i < inputItems.size() ? inputItems[i] : static_cast<int>(i * 7)) % 48 - 24;
+        }
+        std::vector<std::uint32_t> uint32s(keys.begin(), keys.end());
+        std::vector<std::int64_t> int64s(keys.begin(), keys.end());
+        std::vector<float> floats(keys.begin(), keys.end());
+        std::vector<double> doubles(keys.begin(), keys.end());
+        for (std::size_t i = 0; i < size; i += 9)
+        {
+            floats[i] = -0.0f;
+            doubles[i] = -0.0;
+        }
+        floats[3] = std::numeric_limits<float>::infinity();
+        floats[300] = -std::numeric_limits<float>::infinity();
+        doubles[3] = std::numeric_limits<double>::infinity();
+        doubles[300] = -std::numeric_limits<double>::infinity();
+        for (std::int64_t &item : int64s)
+        {
+            item *= std::int64_t{1} << 40;
+        }
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        bool partitioned{simdPartitions(uint32s, std::less<std::uint32_t>{}) &&
+                         simdPartitions(uint32s, std::greater<std::uint32_t>{}) &&
+                         simdPartitions(int64s, std::less<std::int64_t>{}) &&
+                         simdPartitions(int64s, std::greater<std::int64_t>{}) &&
+                         simdPartitions(floats, std::less<float>{}) && simdPartitions(floats, std::greater<float>{}) &&
+                         simdPartitions(doubles, std::less<double>{}) && simdPartitions(doubles, std::greater<double>{})};
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (partitioned)
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "ou::detail::simd_partition succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "ou::detail::simd_partition failed." << std::endl;
         }
     }
     // std::sort
@@ -101,6 +1097,59 @@ void test(const std::vector<int> &inputItems)
             std::clog << "std::sort failed." << std::endl;
         }
     }
+    // std::stable_sort
+    {
+        std::vector<int> items{inputItems};
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        std::stable_sort(items.begin(), items.end());
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (std::is_sorted(items.begin(), items.end()))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "std::stable_sort succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "std::stable_sort failed." << std::endl;
+        }
+    }
+    // std::nth_element
+    if (!inputItems.empty())
+    {
+        std::vector<int> items{inputItems};
+        std::vector<int>::iterator nth{items.begin() + items.size() / 2};
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        std::nth_element(items.begin(), nth, items.end());
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (std::all_of(items.begin(), nth, [&](int item) { return item <= *nth; }) &&
+            std::all_of(nth, items.end(), [&](int item) { return *nth <= item; }))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "std::nth_element succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "std::nth_element failed." << std::endl;
+        }
+    }
+    // std::partial_sort
+    {
+        std::vector<int> items{inputItems};
+        std::vector<int>::iterator middle{items.begin() + std::min<std::size_t>(items.size(), 100)};
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        std::partial_sort(items.begin(), middle, items.end());
+        std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+        if (std::is_sorted(items.begin(), middle) &&
+            (middle == items.begin() || std::all_of(middle, items.end(), [&](int item) { return *(middle - 1) <= item; })))
+        {
+            double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+            std::clog << "std::partial_sort succeeded. " << std::fixed << seconds << " [s]" << std::endl;
+        }
+        else
+        {
+            std::clog << "std::partial_sort failed." << std::endl;
+        }
+    }
 }
 
 int main(int argc, char *argv[])
@@ -137,6 +1186,19 @@ int main(int argc, char *argv[])
             }
             test(items);
         }
+        {
+            // Like status codes or category IDs: millions of rows, a handful of keys.
+            constexpr int keys = 16;
+            std::clog << n << " items with " << keys << " distinct values:" << std::endl;
+            std::vector<int> items(n);
+            for (int i = 0; i < items.size(); ++i)
+            {
+                std::uniform_int_distribution<int> dis{0, keys - 1};
+                int item = dis(gen);
+                items[i] = item;
+            }
+            test(items);
+        }
         {
             std::clog << n << " items sorted in ascending order:" << std::endl;
             std::vector<int> items(n);
@@ -171,6 +1233,100 @@ int main(int argc, char *argv[])
             }
             test(items);
         }
+        {
+            // A sorted array with a few new records appended.
+            std::clog << n << " items sorted with " << n / 100 << " random items appended:" << std::endl;
+            std::vector<int> items(n);
+            for (int i = 0; i < items.size(); ++i)
+            {
+                std::uniform_int_distribution<int> dis{0, n - 1};
+                int item = dis(gen);
+                items[i] = item;
+            }
+            std::sort(items.begin(), items.end() - n / 100);
+            test(items);
+        }
+        {
+            constexpr int runs = 16;
+            std::clog << n << " items in " << runs << " sorted runs concatenated:" << std::endl;
+            std::vector<int> items(n);
+            for (int i = 0; i < items.size(); ++i)
+            {
+                std::uniform_int_distribution<int> dis{0, n - 1};
+                int item = dis(gen);
+                items[i] = item;
+            }
+            for (int r = 0; r < runs; ++r)
+            {
+                std::sort(items.begin() + (static_cast<long long>(n) * r / runs),
+                          items.begin() + (static_cast<long long>(n) * (r + 1) / runs));
+            }
+            test(items);
+        }
+        {
+            std::clog << n << " items arranged in organ-pipe order:" << std::endl;
+            std::vector<int> items(n);
+            for (int i = 0; i < items.size(); ++i)
+            {
+                items[i] = i < n / 2 ? i : n - 1 - i;
+            }
+            test(items, true);
+        }
+        {
+            // David R. Musser, "Introspective Sorting and Selection Algorithms" (1997)
+            std::clog << n << " items arranged as median-of-3 killer:" << std::endl;
+            std::vector<int> items(n);
+            int k = n / 2;
+            for (int i = 1; i <= k; ++i)
+            {
+                if (i % 2 == 1)
+                {
+                    items[i - 1] = i;
+                    // With k odd, slot k belongs to the second half.
+                    if (i < k)
+                    {
+                        items[i] = k + i;
+                    }
+                }
+                items[k + i - 1] = 2 * i;
+            }
+            if (n % 2 == 1)
+            {
+                items[n - 1] = n;
+            }
+            test(items, true);
+        }
+        {
+            // Distinct keys in descending order, large enough that a pivot rule defeated by the
+            // SIMD partition turns quick_sort quadratic. heap_sort is the O(n log n) yardstick.
+            constexpr int size = 1 << 22;
+            std::clog << size << " distinct items sorted in descending order:" << std::endl;
+            std::vector<int> items(size);
+            for (int i = 0; i < size; ++i)
+            {
+                items[i] = size - i;
+            }
+            std::vector<int> quickItems{items};
+            std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+            ou::quick_sort(quickItems.begin(), quickItems.end());
+            std::chrono::steady_clock::time_point end{std::chrono::steady_clock::now()};
+            std::vector<int> heapItems{items};
+            std::chrono::steady_clock::time_point heapStart{std::chrono::steady_clock::now()};
+            ou::heap_sort(heapItems.begin(), heapItems.end());
+            std::chrono::steady_clock::time_point heapEnd{std::chrono::steady_clock::now()};
+            if (std::is_sorted(quickItems.begin(), quickItems.end()) && end - start <= heapEnd - heapStart)
+            {
+                double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+                double heapSeconds =
+                    std::chrono::duration_cast<std::chrono::microseconds>(heapEnd - heapStart).count() / 1000000.0;
+                std::clog << "ou::quick_sort succeeded. " << std::fixed << seconds << " [s]"
+                          << " (ou::heap_sort " << heapSeconds << " [s])" << std::endl;
+            }
+            else
+            {
+                std::clog << "ou::quick_sort failed." << std::endl;
+            }
+        }
     }
     catch (const std::exception &e)
     {
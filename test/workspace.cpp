@@ -0,0 +1,239 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// workspace.cpp
+// Copyright (c) 2025 ozk
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <omoteura/intro_sort.h>
+#include <omoteura/stable_sort.h>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace ou = omoteura;
+
+namespace
+{
+    std::atomic<std::uint64_t> allocations{0};
+    // While set, every allocation fails, as when memory runs out.
+    std::atomic<bool> failAllocations{false};
+} // namespace
+
+// Every allocation in the program goes through here so that the sorts can be checked for it.
+void *operator new(std::size_t size)
+{
+    ++allocations;
+    if (failAllocations.load())
+    {
+        throw std::bad_alloc{};
+    }
+    if (void *pointer = std::malloc(size == 0 ? 1 : size))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc{};
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+namespace
+{
+    struct record
+    {
+        std::uint32_t key;
+        std::uint32_t value;
+    };
+
+    // Runs sort on fresh copies of inputItems, a few times to warm up and then several more
+    // times, and reports whether the later runs allocated.
+    template <typename T, typename Sort, typename IsSorted>
+    bool check(const std::string &name, const std::vector<T> &inputItems, Sort sort, IsSorted isSorted)
+    {
+        constexpr int warmUps = 2;
+        constexpr int runs = 5;
+        std::vector<T> items(inputItems.size());
+        std::uint64_t steadyAllocations{0};
+        bool sorted{true};
+        for (int i = 0; i < warmUps + runs; ++i)
+        {
+            std::copy(inputItems.begin(), inputItems.end(), items.begin());
+            std::uint64_t before{allocations.load()};
+            sort(items);
+            if (i >= warmUps)
+            {
+                steadyAllocations += allocations.load() - before;
+            }
+            sorted = sorted && isSorted(items);
+        }
+        if (sorted && steadyAllocations == 0)
+        {
+            std::clog << name << " succeeded." << std::endl;
+            return true;
+        }
+        std::clog << name << " failed. " << steadyAllocations << " allocations" << std::endl;
+        return false;
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        int n = 200000;
+        if (argc > 1)
+        {
+            n = std::stoi(argv[1]);
+        }
+        if (n < 0)
+        {
+            std::cerr << "Usage: workspace [number of items]" << std::endl;
+            return 1;
+        }
+
+        std::mt19937 engine{12345};
+        std::vector<int> ints(n);
+        for (int &item : ints)
+        {
+            item = static_cast<int>(engine());
+        }
+        std::vector<double> doubles(n);
+        std::uniform_real_distribution<double> distribution{-1.0, 1.0};
+        for (double &item : doubles)
+        {
+            item = distribution(engine);
+        }
+        std::vector<record> records(n);
+        for (record &item : records)
+        {
+            item = record{static_cast<std::uint32_t>(engine()), static_cast<std::uint32_t>(engine())};
+        }
+        // Sorted by key except for the last tenth, as after appending to a sorted table. Taken by
+        // sort_presorted, which merges the sorted tail into the prefix through a buffer.
+        std::vector<record> appendedRecords{records};
+        std::sort(appendedRecords.begin(),
+                  appendedRecords.end() - n / 10,
+                  [](const record &a, const record &b) { return a.key < b.key; });
+        auto intsSorted = [](const std::vector<int> &v) { return std::is_sorted(v.begin(), v.end()); };
+        auto doublesSorted = [](const std::vector<double> &v) { return std::is_sorted(v.begin(), v.end()); };
+        auto recordsSorted = [](const std::vector<record> &v) {
+            return std::is_sorted(v.begin(), v.end(), [](const record &a, const record &b) { return a.key < b.key; });
+        };
+
+        bool passed{true};
+        ou::sort_workspace workspace;
+        passed &= check(
+            "ou::intro_sort (workspace)",
+            ints,
+            [&workspace](std::vector<int> &v) { ou::intro_sort(v.begin(), v.end(), std::less<int>{}, workspace); },
+            intsSorted);
+        passed &= check(
+            "ou::intro_sort (workspace, double)",
+            doubles,
+            [&workspace](std::vector<double> &v) { ou::intro_sort(v.begin(), v.end(), std::less<double>{}, workspace); },
+            doublesSorted);
+        passed &= check(
+            "ou::radix_sort (workspace)",
+            ints,
+            [&workspace](std::vector<int> &v) { ou::radix_sort(v.begin(), v.end(), std::less<int>{}, workspace); },
+            intsSorted);
+        passed &= check(
+            "ou::intro_sort_by_key (workspace)",
+            records,
+            [&workspace](std::vector<record> &v) {
+                ou::intro_sort_by_key(v.begin(), v.end(), &record::key, std::less<std::uint32_t>{}, workspace);
+            },
+            recordsSorted);
+        passed &= check(
+            "ou::intro_sort_by_key (workspace, sorted prefix, comparator)",
+            appendedRecords,
+            [&workspace](std::vector<record> &v) {
+                // A comparator radix sort does not take, so the entries go through intro_sort.
+                ou::intro_sort_by_key(
+                    v.begin(), v.end(), &record::key,
+                    [](std::uint32_t a, std::uint32_t b) { return a < b; }, workspace);
+            },
+            recordsSorted);
+        passed &= check(
+            "ou::intro_sort (thread_local_workspace)",
+            ints,
+            [](std::vector<int> &v) {
+                ou::intro_sort(v.begin(), v.end(), std::less<int>{}, ou::thread_local_workspace());
+            },
+            intsSorted);
+        passed &= check(
+            "ou::intro_sort_by_key (thread_local_workspace)",
+            records,
+            [](std::vector<record> &v) {
+                ou::intro_sort_by_key(
+                    v.begin(), v.end(), &record::key, std::less<std::uint32_t>{}, ou::thread_local_workspace());
+            },
+            recordsSorted);
+        {
+            // Many equal keys, with the original position as the value. No merge buffer can be
+            // obtained, so every merge of stable_sort rotates in place.
+            std::vector<record> items(n);
+            for (int i = 0; i < n; ++i)
+            {
+                items[i] = record{static_cast<std::uint32_t>(engine() % 16), static_cast<std::uint32_t>(i)};
+            }
+            std::vector<record> buffer;
+            failAllocations.store(true);
+            ou::stable_sort(
+                items.begin(), items.end(), [](const record &a, const record &b) { return a.key < b.key; }, buffer);
+            failAllocations.store(false);
+            bool stable{std::is_sorted(items.begin(), items.end(), [](const record &a, const record &b) {
+                return a.key < b.key || (a.key == b.key && a.value < b.value);
+            })};
+            if (stable && buffer.capacity() == 0)
+            {
+                std::clog << "ou::stable_sort (no buffer) succeeded." << std::endl;
+            }
+            else
+            {
+                std::clog << "ou::stable_sort (no buffer) failed." << std::endl;
+                passed = false;
+            }
+        }
+        if (!passed)
+        {
+            return 1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "An exception occurred: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}